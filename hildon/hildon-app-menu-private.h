@@ -41,6 +41,9 @@ struct                                          _HildonAppMenuPrivate
     gint width_request;
     guint find_intruder_idle_id;
     guint hide_idle_id;
+    guint repack_idle_id;
+    gboolean prewarm;
+    guint prewarm_idle_id;
 };
 
 void G_GNUC_INTERNAL
@@ -53,6 +56,12 @@ hildon_app_menu_get_parent_window              (HildonAppMenu *self);
 gboolean G_GNUC_INTERNAL
 hildon_app_menu_has_visible_children (HildonAppMenu *menu);
 
+void G_GNUC_INTERNAL
+hildon_app_menu_queue_prewarm                  (HildonAppMenu *menu);
+
+void G_GNUC_INTERNAL
+hildon_app_menu_release_prewarm                (HildonAppMenu *menu);
+
 G_END_DECLS
 
 #endif /* __HILDON_APP_MENU_PRIVATE_H__ */
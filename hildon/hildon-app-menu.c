@@ -103,12 +103,15 @@
 #include                                        "hildon-app-menu.h"
 #include                                        "hildon-app-menu-private.h"
 #include                                        "hildon-window.h"
+#include                                        "hildon-window-private.h"
 #include                                        "hildon-banner.h"
 #include                                        "hildon-animation-actor.h"
 
 static void
-hildon_app_menu_repack_items                    (HildonAppMenu *menu,
-                                                 gint           start_from);
+hildon_app_menu_queue_repack_items              (HildonAppMenu *menu);
+
+static void
+hildon_app_menu_flush_repack_items              (HildonAppMenu *menu);
 
 static void
 hildon_app_menu_repack_filters                  (HildonAppMenu *menu);
@@ -195,7 +198,7 @@ hildon_app_menu_insert                          (HildonAppMenu *menu,
     g_object_ref_sink (item);
     priv->buttons = g_list_insert (priv->buttons, item, position);
     if (gtk_widget_get_visible (GTK_WIDGET (item)))
-        hildon_app_menu_repack_items (menu, position);
+        hildon_app_menu_queue_repack_items (menu);
 
     /* Enable accelerators */
     g_signal_connect (item, "can-activate-accel", G_CALLBACK (can_activate_accel), NULL);
@@ -274,7 +277,7 @@ hildon_app_menu_reorder_child                   (HildonAppMenu *menu,
     priv->buttons = g_list_remove (priv->buttons, item);
     priv->buttons = g_list_insert (priv->buttons, item, position);
 
-    hildon_app_menu_repack_items (menu, MIN (old_position, position));
+    hildon_app_menu_queue_repack_items (menu);
 }
 
 /**
@@ -334,7 +337,7 @@ hildon_app_menu_set_columns                     (HildonAppMenu *menu,
 
     if (columns != priv->columns) {
         priv->columns = columns;
-        hildon_app_menu_repack_items (menu, 0);
+        hildon_app_menu_queue_repack_items (menu);
     }
 }
 
@@ -424,7 +427,7 @@ item_visibility_changed                         (GtkWidget     *item,
     HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
 
     if (! priv->inhibit_repack)
-        hildon_app_menu_repack_items (menu, g_list_index (priv->buttons, item));
+        hildon_app_menu_queue_repack_items (menu);
     g_signal_emit (menu, app_menu_signals[CHANGED], 0);
 }
 
@@ -468,10 +471,19 @@ hildon_app_menu_show_all                        (GtkWidget *widget)
 
     priv->inhibit_repack = FALSE;
 
-    hildon_app_menu_repack_items (menu, 0);
+    hildon_app_menu_queue_repack_items (menu);
     hildon_app_menu_repack_filters (menu);
 }
 
+static void
+hildon_app_menu_show                            (GtkWidget *widget)
+{
+    /* The size of the menu is computed right away */
+    hildon_app_menu_flush_repack_items (HILDON_APP_MENU (widget));
+
+    GTK_WIDGET_CLASS (hildon_app_menu_parent_class)->show (widget);
+}
+
 
 /*
  * There's a race condition that can freeze the UI if a dialog appears
@@ -491,28 +503,31 @@ hildon_app_menu_find_intruder                   (gpointer data)
         GdkScreen *screen = gtk_widget_get_screen (widget);
         GList *stack = gdk_screen_get_window_stack (screen);
         GList *parent_pos = g_list_find (stack, gtk_widget_get_window (GTK_WIDGET (priv->parent_window)));
-        GList *toplevels = gtk_window_list_toplevels ();
         GList *i;
 
-        for (i = toplevels; i != NULL && !intruder_found; i = i->next) {
-            if (i->data != widget && i->data != priv->parent_window) {
-                if (g_list_find (parent_pos, gtk_widget_get_window (GTK_WIDGET (i->data)))) {
-                    /* HildonBanners are not closed automatically when
-                     * a new window appears, so we must close them by
-                     * hand to make the AppMenu work as expected.
-                     * Yes, this is a hack. See NB#111027 */
-                    if (HILDON_IS_BANNER (i->data)) {
-                        gtk_widget_hide (i->data);
-                    } else if (GTK_IS_WINDOW (i->data)) {
-                        intruder_found = gtk_window_get_modal (i->data);
-                    }
-                }
+        /* Only the windows stacked above the parent window matter.
+         * Our own toplevels are told apart from foreign windows by
+         * the widget they belong to. */
+        for (i = parent_pos ? parent_pos->next : NULL; i != NULL && !intruder_found; i = i->next) {
+            gpointer toplevel = NULL;
+
+            gdk_window_get_user_data (i->data, &toplevel);
+            if (toplevel == NULL || toplevel == widget)
+                continue;
+
+            /* HildonBanners are not closed automatically when
+             * a new window appears, so we must close them by
+             * hand to make the AppMenu work as expected.
+             * Yes, this is a hack. See NB#111027 */
+            if (HILDON_IS_BANNER (toplevel)) {
+                gtk_widget_hide (toplevel);
+            } else if (GTK_IS_WINDOW (toplevel)) {
+                intruder_found = gtk_window_get_modal (toplevel);
             }
         }
 
         g_list_foreach (stack, (GFunc) g_object_unref, NULL);
         g_list_free (stack);
-        g_list_free (toplevels);
 
         if (intruder_found)
             gtk_widget_hide (widget);
@@ -753,54 +768,61 @@ hildon_app_menu_repack_filters                  (HildonAppMenu *menu)
 /*
  * When items displayed in the menu change (e.g, a new item is added,
  * an item is hidden or the list is reordered), the layout must be
- * updated. To do this we repack all items starting from a given one.
+ * updated. Changes are batched into a single repack, which computes
+ * the cell of every visible item and only touches the items whose
+ * cell changed.
  */
 static void
-hildon_app_menu_repack_items                    (HildonAppMenu *menu,
-                                                 gint           start_from)
+hildon_app_menu_repack_items                    (HildonAppMenu *menu)
 {
     HildonAppMenuPrivate *priv;
-    gint row, col, nvisible, i;
+    GtkContainer *table;
+    guint row, col, nvisible, n_rows, old_rows, old_columns, left, top;
     GList *iter;
 
     priv = HILDON_APP_MENU_GET_PRIVATE(menu);
+    table = GTK_CONTAINER (priv->table);
 
-    i = nvisible = 0;
+    nvisible = 0;
     for (iter = priv->buttons; iter != NULL; iter = iter->next) {
-        /* Count number of visible items */
-        if (gtk_widget_get_visible (iter->data))
+        GtkWidget *item = GTK_WIDGET (iter->data);
+        /* Count number of visible items, remove the hidden ones */
+        if (gtk_widget_get_visible (item)) {
             nvisible++;
-        /* Remove buttons from their parent */
-        if (start_from != -1 && i >= start_from) {
-            GtkWidget *item = GTK_WIDGET (iter->data);
-            GtkWidget *parent = gtk_widget_get_parent (item);
-            if (parent) {
-                g_object_ref (item);
-                gtk_container_remove (GTK_CONTAINER (parent), item);
-            }
+        } else if (gtk_widget_get_parent (item) != NULL) {
+            g_object_ref (item);
+            gtk_container_remove (table, item);
         }
-        i++;
     }
 
-    /* If items have been removed, recalculate the size of the menu */
-    if (start_from != -1)
-        gtk_window_resize (GTK_WINDOW (menu), 1, 1);
+    /* Grow the table first, so moving items doesn't resize it */
+    n_rows = nvisible > 0 ? ((nvisible - 1) / priv->columns) + 1 : 1;
+    gtk_table_get_size (priv->table, &old_rows, &old_columns);
+    if (n_rows > old_rows || priv->columns > old_columns)
+        gtk_table_resize (priv->table, MAX (n_rows, old_rows), MAX (priv->columns, old_columns));
 
-    /* Set the final size now to avoid unnecessary resizes later */
-    if (nvisible > 0)
-        gtk_table_resize (priv->table, ((nvisible - 1) / priv->columns) + 1, priv->columns);
-
-    /* Add buttons */
+    /* Add new items and move the ones whose cell changed */
     row = col = 0;
     for (iter = priv->buttons; iter != NULL; iter = iter->next) {
         GtkWidget *item = GTK_WIDGET (iter->data);
         if (gtk_widget_get_visible (item)) {
-            /* Don't add an item to the table if it's already there */
             if (gtk_widget_get_parent (item) == NULL) {
                 gtk_table_attach_defaults (priv->table, item, col, col + 1, row, row + 1);
                 g_object_unref (item);
                 /* GtkButton must be realized for accelerators to work */
                 gtk_widget_realize (item);
+            } else {
+                gtk_container_child_get (table, item,
+                                         "left-attach", &left,
+                                         "top-attach", &top,
+                                         NULL);
+                if (left != col || top != row)
+                    gtk_container_child_set (table, item,
+                                             "left-attach", col,
+                                             "right-attach", col + 1,
+                                             "top-attach", row,
+                                             "bottom-attach", row + 1,
+                                             NULL);
             }
             if (++col == priv->columns) {
                 col = 0;
@@ -809,9 +831,50 @@ hildon_app_menu_repack_items                    (HildonAppMenu *menu,
         }
     }
 
+    /* Recalculate the size of the menu only if the grid changed */
+    if (n_rows != old_rows || priv->columns != old_columns) {
+        gtk_table_resize (priv->table, n_rows, priv->columns);
+        gtk_window_resize (GTK_WINDOW (menu), 1, 1);
+    }
+
     gtk_widget_queue_draw (GTK_WIDGET (menu));
 }
 
+static gboolean
+hildon_app_menu_repack_idle                     (gpointer data)
+{
+    HildonAppMenu *menu = HILDON_APP_MENU (data);
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    priv->repack_idle_id = 0;
+    hildon_app_menu_repack_items (menu);
+
+    return FALSE;
+}
+
+static void
+hildon_app_menu_queue_repack_items              (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    /* Before GTK+ computes the new size of the menu */
+    if (priv->repack_idle_id == 0)
+        priv->repack_idle_id = gdk_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                                          hildon_app_menu_repack_idle,
+                                                          menu, NULL);
+}
+
+static void
+hildon_app_menu_flush_repack_items              (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (priv->repack_idle_id) {
+        g_source_remove (priv->repack_idle_id);
+        hildon_app_menu_repack_idle (menu);
+    }
+}
+
 /**
  * hildon_app_menu_has_visible_children:
  * @menu: a #HildonAppMenu
@@ -870,6 +933,154 @@ hildon_app_menu_popup                           (HildonAppMenu *menu,
 
 }
 
+static gboolean
+hildon_app_menu_prewarm_idle                    (gpointer data)
+{
+    HildonAppMenu *menu = HILDON_APP_MENU (data);
+    GtkRequisition requisition;
+    HildonAppMenuPrivate *priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    priv->prewarm_idle_id = 0;
+
+    if (gtk_widget_get_visible (GTK_WIDGET (menu)))
+        return FALSE;
+
+    /* Everything a popup does before mapping the menu */
+    hildon_app_menu_flush_repack_items (menu);
+    gtk_widget_realize (GTK_WIDGET (menu));
+    hildon_app_menu_flush_repack_items (menu);
+    gtk_widget_get_preferred_size (GTK_WIDGET (menu), NULL, &requisition);
+
+    return FALSE;
+}
+
+/*
+ * Called by HildonWindow when the window that shows @menu gets mapped
+ * or becomes the topmost window again.
+ */
+void G_GNUC_INTERNAL
+hildon_app_menu_queue_prewarm                   (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_APP_MENU (menu));
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (! priv->prewarm || priv->prewarm_idle_id != 0 ||
+        gtk_widget_get_visible (GTK_WIDGET (menu)))
+        return;
+
+    /* Menu items must be realized for accelerators to work, so a
+     * released menu can't wait for the idle to come back */
+    if (! gtk_widget_get_realized (GTK_WIDGET (menu)) && priv->buttons != NULL)
+        gtk_widget_realize (GTK_WIDGET (menu));
+
+    priv->prewarm_idle_id = gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                                       hildon_app_menu_prewarm_idle,
+                                                       g_object_ref (menu),
+                                                       g_object_unref);
+}
+
+/*
+ * Called by HildonWindow when the window that shows @menu goes to
+ * the background while the task navigator may hibernate its program
+ * to reclaim memory. The menu is unrealized until it's needed again.
+ */
+void G_GNUC_INTERNAL
+hildon_app_menu_release_prewarm                 (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_APP_MENU (menu));
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    if (! priv->prewarm || gtk_widget_get_visible (GTK_WIDGET (menu)))
+        return;
+
+    if (priv->prewarm_idle_id) {
+        g_source_remove (priv->prewarm_idle_id);
+        priv->prewarm_idle_id = 0;
+    }
+
+    if (gtk_widget_get_realized (GTK_WIDGET (menu)))
+        gtk_widget_unrealize (GTK_WIDGET (menu));
+}
+
+/**
+ * hildon_app_menu_set_prewarm:
+ * @menu: a #HildonAppMenu
+ * @prewarm: whether to prepare @menu in advance
+ *
+ * Sets whether @menu is realized and laid out in idle time, after the
+ * #HildonWindow that shows it is mapped, so the first call to
+ * hildon_app_menu_popup() shows it right away. If that window is
+ * already mapped, @menu is prepared in the next idle. A prepared menu
+ * is released again while its window is in the background and the
+ * program can be hibernated.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_app_menu_set_prewarm                     (HildonAppMenu *menu,
+                                                 gboolean       prewarm)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_APP_MENU (menu));
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    prewarm = prewarm ? TRUE : FALSE;
+    if (priv->prewarm == prewarm)
+        return;
+
+    priv->prewarm = prewarm;
+
+    if (! prewarm && priv->prewarm_idle_id) {
+        g_source_remove (priv->prewarm_idle_id);
+        priv->prewarm_idle_id = 0;
+    }
+
+    /* The window showing the menu may already be mapped, it won't
+     * queue anything until it's mapped again */
+    if (prewarm) {
+        GList *toplevels, *l;
+
+        toplevels = gtk_window_list_toplevels ();
+        for (l = toplevels; l != NULL; l = l->next) {
+            if (HILDON_IS_WINDOW (l->data) &&
+                gtk_widget_get_mapped (GTK_WIDGET (l->data)) &&
+                hildon_window_get_active_app_menu (l->data) == menu) {
+                hildon_app_menu_queue_prewarm (menu);
+                break;
+            }
+        }
+        g_list_free (toplevels);
+    }
+}
+
+/**
+ * hildon_app_menu_get_prewarm:
+ * @menu: a #HildonAppMenu
+ *
+ * Returns whether @menu is prepared in advance. See
+ * hildon_app_menu_set_prewarm().
+ *
+ * Returns: %TRUE if @menu is prepared in advance
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_app_menu_get_prewarm                     (HildonAppMenu *menu)
+{
+    HildonAppMenuPrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_APP_MENU (menu), FALSE);
+
+    priv = HILDON_APP_MENU_GET_PRIVATE (menu);
+
+    return priv->prewarm;
+}
+
 /**
  * hildon_app_menu_get_items:
  * @menu: a #HildonAppMenu
@@ -933,6 +1144,9 @@ hildon_app_menu_init                            (HildonAppMenu *menu)
     priv->width_request = -1;
     priv->find_intruder_idle_id = 0;
     priv->hide_idle_id = 0;
+    priv->repack_idle_id = 0;
+    priv->prewarm = FALSE;
+    priv->prewarm_idle_id = 0;
 
     /* Create boxes and tables */
     priv->filters_hbox = GTK_BOX (gtk_hbox_new (TRUE, 0));
@@ -974,6 +1188,20 @@ hildon_app_menu_dispose                         (GObject *object)
     g_list_foreach (priv->buttons, (GFunc) disconnect_weak_refs, object);
     g_list_foreach (priv->filters, (GFunc) disconnect_weak_refs, object);
 
+    /* The table is destroyed below, a pending repack must not attach
+     * items to it anymore. Items that were never attached still own
+     * the reference taken in hildon_app_menu_insert(), which is
+     * released in finalize. */
+    if (priv->repack_idle_id) {
+        g_source_remove (priv->repack_idle_id);
+        priv->repack_idle_id = 0;
+    }
+
+    if (priv->prewarm_idle_id) {
+        g_source_remove (priv->prewarm_idle_id);
+        priv->prewarm_idle_id = 0;
+    }
+
     G_OBJECT_CLASS (hildon_app_menu_parent_class)->dispose (object);
 }
 
@@ -1018,6 +1246,7 @@ hildon_app_menu_class_init                      (HildonAppMenuClass *klass)
 
     gobject_class->dispose = hildon_app_menu_dispose;
     gobject_class->finalize = hildon_app_menu_finalize;
+    widget_class->show = hildon_app_menu_show;
     widget_class->show_all = hildon_app_menu_show_all;
     widget_class->map = hildon_app_menu_map;
     widget_class->realize = hildon_app_menu_realize;
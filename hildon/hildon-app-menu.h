@@ -98,6 +98,13 @@ hildon_app_menu_get_items                       (HildonAppMenu *menu);
 GList *
 hildon_app_menu_get_filters                     (HildonAppMenu *menu);
 
+void
+hildon_app_menu_set_prewarm                     (HildonAppMenu *menu,
+                                                 gboolean       prewarm);
+
+gboolean
+hildon_app_menu_get_prewarm                     (HildonAppMenu *menu);
+
 G_END_DECLS
 
 #endif /* __HILDON_APP_MENU_H__ */
@@ -53,6 +53,9 @@
  * Information banners are automatically destroyed after a certain
  * period. This is stored in the #HildonBanner:timeout property (in
  * miliseconds), and can be changed using hildon_banner_set_timeout().
+ * Applications showing many of them can make an information banner
+ * #HildonBanner:reusable, it is then hidden instead, and the next
+ * information banner of the same window reuses it.
  *
  * Note that #HildonBanner<!-- -->s should only be used to display
  * non-critical pieces of information.
@@ -94,6 +97,12 @@
 
 #define                                         HILDON_BANNER_DEFAULT_TIMEOUT 3000
 
+/* default pacing of the messages of a visible banner */
+
+#define                                         HILDON_BANNER_DEFAULT_MINIMUM_DISPLAY_TIME 0
+
+#define                                         HILDON_BANNER_DEFAULT_UPDATE_INTERVAL 0
+
 /* default icons */
 
 #define                                         HILDON_BANNER_DEFAULT_PROGRESS_ANIMATION "indicator_update"
@@ -111,7 +120,10 @@ enum
     PROP_0,
     PROP_PARENT_WINDOW, 
     PROP_IS_TIMED,
-    PROP_TIMEOUT
+    PROP_TIMEOUT,
+    PROP_MINIMUM_DISPLAY_TIME,
+    PROP_UPDATE_INTERVAL,
+    PROP_REUSABLE
 };
 
 static GtkWidget*                               global_timed_banner = NULL;
@@ -191,6 +203,28 @@ hildon_banner_set_override_flag                 (HildonBanner *banner);
 static void
 reshow_banner                                   (HildonBanner *banner);
 
+static void
+unpack_main_widget_pack_label                   (HildonBanner *banner);
+
+static void
+hildon_banner_retire                            (HildonBanner *banner);
+
+static void
+banner_do_set_text                              (HildonBanner *banner,
+                                                 const gchar  *text,
+                                                 gboolean      is_markup);
+
+static void
+banner_cancel_pending                           (HildonBanner *banner);
+
+static void
+banner_flush_pending                            (HildonBanner *banner);
+
+static gboolean
+banner_queue_text                               (HildonBanner *banner,
+                                                 const gchar  *text,
+                                                 gboolean      is_markup);
+
 static GtkWidget*
 hildon_banner_real_show_information             (GtkWidget *widget,
                                                  const gchar *text,
@@ -214,7 +248,15 @@ struct                                          _HildonBannerPrivate
     const gchar *name_suffix;
     guint        timeout;
     guint        timeout_id;
+    guint        minimum_display_time;
+    guint        update_interval;
+    gint64       shown_time;
+    gint64       update_time;
+    gchar       *pending_text;
+    guint        pending_id;
+    guint        pending_is_markup    : 1;
     guint        is_timed             : 1;
+    guint        reusable             : 1;
     guint        require_override_dnd : 1;
     guint        overrides_dnd        : 1;
 };
@@ -251,7 +293,7 @@ hildon_banner_bind_style                  (HildonBanner *self)
     g_free (name);
 }
 
-/* In timeout function we automatically destroy timed banners */
+/* In timeout function we automatically close timed banners */
 static gboolean
 simulate_close (GtkWidget* widget)
 {
@@ -291,6 +333,13 @@ hildon_banner_timeout                           (gpointer data)
     g_assert (HILDON_IS_BANNER (data));
 
     widget = GTK_WIDGET (data);
+
+    /* A queued message gets its own timeout before the banner goes */
+    if (HILDON_BANNER_GET_PRIVATE (data)->pending_text != NULL) {
+        banner_flush_pending (HILDON_BANNER (data));
+        return FALSE;
+    }
+
     g_object_ref (widget);
 
     continue_timeout = simulate_close (widget);
@@ -301,7 +350,10 @@ hildon_banner_timeout                           (gpointer data)
             g_source_remove (priv->timeout_id);
             priv->timeout_id = 0;
         }
-        gtk_widget_destroy (widget);
+        if (priv->is_timed && priv->reusable)
+            hildon_banner_retire (HILDON_BANNER (widget));
+        else
+            gtk_widget_destroy (widget);
     }
 
     g_object_unref (widget);
@@ -350,6 +402,18 @@ hildon_banner_set_property                      (GObject *object,
         case PROP_TIMEOUT:
              priv->timeout = g_value_get_uint (value);
              break;
+
+        case PROP_MINIMUM_DISPLAY_TIME:
+            priv->minimum_display_time = g_value_get_uint (value);
+            break;
+
+        case PROP_UPDATE_INTERVAL:
+            priv->update_interval = g_value_get_uint (value);
+            break;
+
+        case PROP_REUSABLE:
+            priv->reusable = g_value_get_boolean (value);
+            break;
  
         case PROP_IS_TIMED:
             priv->is_timed = g_value_get_boolean (value);
@@ -391,6 +455,18 @@ hildon_banner_get_property                      (GObject *object,
         case PROP_TIMEOUT:
              g_value_set_uint (value, priv->timeout);
              break;
+
+        case PROP_MINIMUM_DISPLAY_TIME:
+            g_value_set_uint (value, priv->minimum_display_time);
+            break;
+
+        case PROP_UPDATE_INTERVAL:
+            g_value_set_uint (value, priv->update_interval);
+            break;
+
+        case PROP_REUSABLE:
+            g_value_set_boolean (value, priv->reusable);
+            break;
  
         case PROP_IS_TIMED:
             g_value_set_boolean (value, priv->is_timed);
@@ -435,6 +511,11 @@ hildon_banner_destroy                           (GtkWidget *object)
 
     (void) hildon_banner_clear_timeout (self);
 
+    /* The queued message is the last one of the banner */
+    if (priv->pending_text != NULL && priv->label != NULL)
+        banner_do_set_text (self, priv->pending_text, priv->pending_is_markup);
+    banner_cancel_pending (self);
+
     if (GTK_WIDGET_CLASS (hildon_banner_parent_class)->destroy)
         GTK_WIDGET_CLASS (hildon_banner_parent_class)->destroy (object);
 }
@@ -572,6 +653,8 @@ hildon_banner_map_event                         (GtkWidget *widget,
 
     hildon_banner_ensure_timeout (HILDON_BANNER(widget));
 
+    HILDON_BANNER_GET_PRIVATE (widget)->shown_time = g_get_monotonic_time ();
+
     return result;
 }  
 
@@ -589,6 +672,105 @@ banner_do_set_text                              (HildonBanner *banner,
     } else {
         gtk_label_set_text (GTK_LABEL (priv->label), text);
     }
+
+    priv->update_time = g_get_monotonic_time ();
+}
+
+static void
+banner_cancel_pending                           (HildonBanner *banner)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+
+    if (priv->pending_id) {
+        g_source_remove (priv->pending_id);
+        priv->pending_id = 0;
+    }
+
+    g_free (priv->pending_text);
+    priv->pending_text = NULL;
+}
+
+static gboolean
+banner_show_pending                             (gpointer data)
+{
+    HildonBanner *banner = HILDON_BANNER (data);
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+
+    priv->pending_id = 0;
+
+    banner_do_set_text (banner, priv->pending_text, priv->pending_is_markup);
+    g_free (priv->pending_text);
+    priv->pending_text = NULL;
+
+    reshow_banner (banner);
+
+    /* The new message gets the whole timeout */
+    if (hildon_banner_clear_timeout (banner))
+        hildon_banner_ensure_timeout (banner);
+
+    return FALSE;
+}
+
+/* Shows the queued message, if any, at once */
+static void
+banner_flush_pending                            (HildonBanner *banner)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+
+    if (priv->pending_text == NULL)
+        return;
+
+    if (priv->pending_id) {
+        g_source_remove (priv->pending_id);
+        priv->pending_id = 0;
+    }
+
+    banner_show_pending (banner);
+}
+
+/* Queues a new message for a timed banner that is already visible,
+   so that a flood of messages can't relayout the banner faster than
+   the update interval, nor replace a message before it has been
+   shown for the minimum display time. Only the last queued message
+   is kept, and messages identical to the visible one are merged
+   into it, restarting its timeout. Returns FALSE if the message
+   should be shown at once. */
+static gboolean
+banner_queue_text                               (HildonBanner *banner,
+                                                 const gchar  *text,
+                                                 gboolean      is_markup)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+    gint64 now, due;
+
+    if (!gtk_widget_get_mapped (GTK_WIDGET (banner)) || priv->main_item != NULL)
+        return FALSE;
+
+    if (gtk_label_get_use_markup (GTK_LABEL (priv->label)) == is_markup &&
+        strcmp (gtk_label_get_label (GTK_LABEL (priv->label)), text) == 0) {
+        banner_cancel_pending (banner);
+        if (hildon_banner_clear_timeout (banner))
+            hildon_banner_ensure_timeout (banner);
+        return TRUE;
+    }
+
+    now = g_get_monotonic_time ();
+    due = MAX (priv->shown_time + (gint64) priv->minimum_display_time * 1000,
+               priv->update_time + (gint64) priv->update_interval * 1000);
+    if (due <= now) {
+        banner_cancel_pending (banner);
+        return FALSE;
+    }
+
+    g_free (priv->pending_text);
+    priv->pending_text = g_strdup (text);
+    priv->pending_is_markup = is_markup;
+
+    if (priv->pending_id == 0)
+        priv->pending_id = gdk_threads_add_timeout ((due - now + 999) / 1000,
+                                                    banner_show_pending, banner);
+
+    return TRUE;
 }
 
 static void
@@ -773,6 +955,61 @@ hildon_banner_class_init                        (HildonBannerClass *klass)
                 10000,
                 HILDON_BANNER_DEFAULT_TIMEOUT,
                 G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+    /**
+     * HildonBanner:minimum-display-time:
+     *
+     * The time in miliseconds a visible information banner is shown
+     * before a new message replaces its first one. The default, 0,
+     * shows new messages at once.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_MINIMUM_DISPLAY_TIME,
+            g_param_spec_uint ("minimum-display-time",
+                "Minimum display time",
+                "The time a banner is shown before a new message replaces it",
+                0,
+                10000,
+                HILDON_BANNER_DEFAULT_MINIMUM_DISPLAY_TIME,
+                G_PARAM_READWRITE));
+
+    /**
+     * HildonBanner:update-interval:
+     *
+     * The minimum time in miliseconds between two messages of a
+     * visible information banner. Messages arriving faster replace
+     * each other, and only the last one is shown. The default, 0,
+     * shows every message.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_UPDATE_INTERVAL,
+            g_param_spec_uint ("update-interval",
+                "Update interval",
+                "The minimum time between two messages of a banner",
+                0,
+                10000,
+                HILDON_BANNER_DEFAULT_UPDATE_INTERVAL,
+                G_PARAM_READWRITE));
+
+    /**
+     * HildonBanner:reusable:
+     *
+     * Whether a timed banner is hidden instead of destroyed when it
+     * times out. A hidden banner is kept as the timed banner of its
+     * window, and the next information banner of that window reuses
+     * it. It is destroyed along with the window, or never if it has
+     * no parent window.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class, PROP_REUSABLE,
+            g_param_spec_boolean ("reusable",
+                "Reusable",
+                "Whether the banner is hidden instead of destroyed on timeout",
+                FALSE,
+                G_PARAM_READWRITE));
 }
 
 static void 
@@ -786,6 +1023,13 @@ hildon_banner_init                              (HildonBanner *self)
     priv->require_override_dnd = FALSE;
     priv->name_suffix = NULL;
     priv->main_item = NULL;
+    priv->minimum_display_time = HILDON_BANNER_DEFAULT_MINIMUM_DISPLAY_TIME;
+    priv->update_interval = HILDON_BANNER_DEFAULT_UPDATE_INTERVAL;
+    priv->shown_time = 0;
+    priv->update_time = 0;
+    priv->pending_text = NULL;
+    priv->pending_id = 0;
+    priv->reusable = FALSE;
 
     /* Initialize the common layout inside banner */
     priv->alignment = gtk_alignment_new (0.5, 0.5, 0, 0);
@@ -832,7 +1076,8 @@ hildon_banner_get_instance_for_widget           (GtkWidget *widget,
  * hildon_banner_set_timeout()). For each window in your application
  * there can only be one timed banner, so if you spawn a new banner
  * before the earlier one has timed out, the previous one will be
- * replaced.
+ * replaced. If the banner was made #HildonBanner:reusable, it is
+ * hidden instead, and the same banner is returned by the next call.
  *
  * Returns: The newly created banner
  *
@@ -902,6 +1147,34 @@ unpack_main_widget_pack_label                   (HildonBanner *banner)
     }
 }
 
+/* Timed banners are singletons of their parent window, or of the
+   application when they have none. Instead of destroying reusable
+   ones when they time out, we hide them and keep them there, so
+   showing the next banner costs a relabel and a map instead of a new
+   X window. */
+static void
+hildon_banner_retire                            (HildonBanner *banner)
+{
+    HildonBannerPrivate *priv = HILDON_BANNER_GET_PRIVATE (banner);
+    g_assert (priv);
+
+    gtk_widget_hide (GTK_WIDGET (banner));
+    banner_cancel_pending (banner);
+
+    /* Don't keep the custom widget of the application alive */
+    unpack_main_widget_pack_label (banner);
+    banner_do_set_text (banner, "", FALSE);
+
+    priv->timeout = HILDON_BANNER_DEFAULT_TIMEOUT;
+
+    if (priv->overrides_dnd && gtk_widget_get_realized (GTK_WIDGET (banner))) {
+        gdk_property_delete (gtk_widget_get_window (GTK_WIDGET (banner)),
+                             gdk_atom_intern_static_string ("_HILDON_DO_NOT_DISTURB_OVERRIDE"));
+    }
+    priv->overrides_dnd = FALSE;
+    priv->require_override_dnd = FALSE;
+}
+
 static GtkWidget*
 hildon_banner_real_show_information             (GtkWidget *widget,
                                                  const gchar *text,
@@ -916,16 +1189,25 @@ hildon_banner_real_show_information             (GtkWidget *widget,
     banner = hildon_banner_get_instance_for_widget (widget, TRUE);
     priv = HILDON_BANNER_GET_PRIVATE (banner);
 
-    priv->name_suffix = "information";
-    unpack_main_widget_pack_label (banner);
-    banner_do_set_text (banner, text, FALSE);
-    hildon_banner_bind_style (banner);
-
     if (override_dnd) {
       /* so on the realize it will set the property */
       priv->require_override_dnd = TRUE;
+
+      /* a reused banner is realized already */
+      if (gtk_widget_get_realized (GTK_WIDGET (banner)) && !priv->overrides_dnd) {
+        hildon_banner_set_override_flag (banner);
+        priv->overrides_dnd = TRUE;
+      }
     }
 
+    if (banner_queue_text (banner, text, FALSE))
+        return GTK_WIDGET (banner);
+
+    priv->name_suffix = "information";
+    unpack_main_widget_pack_label (banner);
+    banner_do_set_text (banner, text, FALSE);
+    hildon_banner_bind_style (banner);
+
     /* Show the banner, since caller cannot do that */
     reshow_banner (banner);
 
@@ -1000,7 +1282,11 @@ hildon_banner_show_information_with_markup      (GtkWidget *widget,
     banner = hildon_banner_get_instance_for_widget (widget, TRUE);
     priv = HILDON_BANNER_GET_PRIVATE (banner);
 
+    if (banner_queue_text (banner, markup, TRUE))
+        return (GtkWidget *) banner;
+
     priv->name_suffix = "information";
+    unpack_main_widget_pack_label (banner);
     banner_do_set_text (banner, markup, TRUE);
     hildon_banner_bind_style (banner);
 
@@ -1038,6 +1324,8 @@ hildon_banner_show_custom_widget                (GtkWidget *widget,
     g_return_val_if_fail (gtk_widget_get_parent (custom_widget) == NULL ||
                           priv->main_item == custom_widget, NULL);
 
+    banner_cancel_pending (banner);
+
     if (priv->main_item == NULL) {
         gtk_container_remove (GTK_CONTAINER (priv->layout), priv->label);
     }
@@ -1081,6 +1369,7 @@ hildon_banner_set_text                          (HildonBanner *self,
 {
     g_return_if_fail (HILDON_IS_BANNER (self));
 
+    banner_cancel_pending (self);
     banner_do_set_text (self, text, FALSE);
 
     if (gtk_widget_get_visible (GTK_WIDGET (self)))
@@ -1101,6 +1390,7 @@ hildon_banner_set_markup                        (HildonBanner *self,
 {
     g_return_if_fail (HILDON_IS_BANNER (self));
 
+    banner_cancel_pending (self);
     banner_do_set_text (self, markup, TRUE);
 
     if (gtk_widget_get_visible (GTK_WIDGET (self)))
@@ -1113,7 +1403,8 @@ hildon_banner_set_markup                        (HildonBanner *self,
  * @timeout: timeout to set in miliseconds.
  *
  * Sets the timeout on the banner. After the given amount of miliseconds
- * has elapsed the banner will be destroyed. Setting this only makes
+ * has elapsed the banner will be destroyed, or hidden if it is
+ * #HildonBanner:reusable. Setting this only makes
  * sense on banners that are timed and that have not been yet displayed
  * on the screen.
  *
@@ -1134,3 +1425,63 @@ hildon_banner_set_timeout                       (HildonBanner *self,
     priv->timeout = timeout;
 }
 
+/**
+ * hildon_banner_set_minimum_display_time:
+ * @self: a #HildonBanner widget
+ * @minimum_display_time: time in miliseconds
+ *
+ * Sets for how long an information banner shows its first message
+ * before a new one replaces it. New messages arriving earlier are
+ * queued, see #HildonBanner:minimum-display-time.
+ *
+ * Since: 3.0
+ */
+void
+hildon_banner_set_minimum_display_time          (HildonBanner *self,
+                                                 guint minimum_display_time)
+{
+    g_return_if_fail (HILDON_IS_BANNER (self));
+
+    g_object_set (self, "minimum-display-time", minimum_display_time, NULL);
+}
+
+/**
+ * hildon_banner_set_reusable:
+ * @self: a #HildonBanner widget
+ * @reusable: whether to hide @self instead of destroying it
+ *
+ * Sets whether an information banner is hidden instead of destroyed
+ * when it times out, so that the next information banner of the same
+ * window reuses it. The banner then lives as long as its parent
+ * window, see #HildonBanner:reusable.
+ *
+ * Since: 3.0
+ */
+void
+hildon_banner_set_reusable                      (HildonBanner *self,
+                                                 gboolean reusable)
+{
+    g_return_if_fail (HILDON_IS_BANNER (self));
+
+    g_object_set (self, "reusable", reusable, NULL);
+}
+
+/**
+ * hildon_banner_set_update_interval:
+ * @self: a #HildonBanner widget
+ * @update_interval: time in miliseconds
+ *
+ * Sets the minimum time between two messages of a visible information
+ * banner. When messages arrive faster, only the last one is shown,
+ * see #HildonBanner:update-interval.
+ *
+ * Since: 3.0
+ */
+void
+hildon_banner_set_update_interval               (HildonBanner *self,
+                                                 guint update_interval)
+{
+    g_return_if_fail (HILDON_IS_BANNER (self));
+
+    g_object_set (self, "update-interval", update_interval, NULL);
+}
@@ -89,6 +89,18 @@ void
 hildon_banner_set_timeout                       (HildonBanner *self,
                                                  guint timeout);
 
+void
+hildon_banner_set_minimum_display_time          (HildonBanner *self,
+                                                 guint minimum_display_time);
+
+void
+hildon_banner_set_update_interval               (HildonBanner *self,
+                                                 guint update_interval);
+
+void
+hildon_banner_set_reusable                      (HildonBanner *self,
+                                                 gboolean reusable);
+
 GtkWidget *
 hildon_banner_show_custom_widget                (GtkWidget *widget,
                                                  GtkWidget *custom_widget);
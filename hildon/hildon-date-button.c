@@ -15,10 +15,12 @@
  */
 
 #include <libintl.h>
+#include <time.h>
 
 #include "hildon-stock.h"
 #include "hildon-date-button.h"
 #include "hildon-date-selector.h"
+#include "hildon-date-selector-private.h"
 #include "hildon-touch-selector.h"
 #include "hildon-picker-button-private.h"
 
@@ -35,16 +37,22 @@
 
 G_DEFINE_TYPE (HildonDateButton, hildon_date_button, HILDON_TYPE_PICKER_BUTTON)
 
-#if 0
 #define GET_PRIVATE(o)                                                  \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), HILDON_TYPE_DATE_BUTTON, HildonDateButtonPrivate))
 
 typedef struct _HildonDateButtonPrivate HildonDateButtonPrivate;
 
+/* Most date buttons of a form are never tapped, so the selector is
+ * only built when it is needed. Until then the date is kept here. */
 struct _HildonDateButtonPrivate
 {
+  gint min_year;
+  gint max_year;
+
+  guint year;
+  guint month;
+  guint day;
 };
-#endif
 
 #if 0
 static void
@@ -68,18 +76,81 @@ hildon_date_button_set_property (GObject * object, guint property_id,
 }
 #endif
 
+static gboolean
+hildon_date_button_date_in_range (HildonDateButton *button,
+                                  guint year, guint month, guint day)
+{
+  HildonDateButtonPrivate *priv = GET_PRIVATE (button);
+  gint min_year, max_year;
+
+  min_year = priv->min_year == -1 ? HILDON_DATE_SELECTOR_DEFAULT_MIN_YEAR : priv->min_year;
+  max_year = priv->max_year == -1 ? HILDON_DATE_SELECTOR_DEFAULT_MAX_YEAR : priv->max_year;
+
+  return (guint) min_year <= year && year <= (guint) max_year &&
+    month < 12 && day <= 31 &&
+    g_date_valid_dmy (day, month + 1, year);
+}
+
+static HildonTouchSelector *
+hildon_date_button_create_selector (HildonPickerButton *button)
+{
+  HildonDateButtonPrivate *priv = GET_PRIVATE (button);
+  GtkWidget *selector;
+
+  selector = hildon_date_selector_new_with_year_range (priv->min_year,
+                                                       priv->max_year);
+  if (selector != NULL &&
+      hildon_date_button_date_in_range (HILDON_DATE_BUTTON (button),
+                                        priv->year, priv->month, priv->day))
+    hildon_date_selector_select_current_date (HILDON_DATE_SELECTOR (selector),
+                                              priv->year, priv->month, priv->day);
+
+  return HILDON_TOUCH_SELECTOR (selector);
+}
+
+static void
+hildon_date_button_show_date (HildonDateButton *button)
+{
+  HildonDateButtonPrivate *priv = GET_PRIVATE (button);
+  gchar *date;
+
+  date = hildon_date_selector_format_date (priv->year, priv->month, priv->day);
+  hildon_button_set_value (HILDON_BUTTON (button), date);
+  g_free (date);
+}
+
 static GObject *
 hildon_date_button_constructor (GType type,
 				guint n_construct_params,
 				GObjectConstructParam *construct_params)
 {
   GObject *object;
+  HildonDateButton *button;
+  HildonDateButtonPrivate *priv;
+  time_t secs;
+  struct tm *tm;
 
   object = G_OBJECT_CLASS (hildon_date_button_parent_class)->constructor (type,
                                                                           n_construct_params,
                                                                           construct_params);
   gtk_button_set_use_stock (GTK_BUTTON (object), TRUE);
 
+  button = HILDON_DATE_BUTTON (object);
+  priv = GET_PRIVATE (button);
+
+  /* No selector was given, defer the default one, selecting today */
+  if (hildon_picker_button_peek_selector (HILDON_PICKER_BUTTON (button)) == NULL) {
+    secs = time (NULL);
+    tm = localtime (&secs);
+    priv->year = 1900 + tm->tm_year;
+    priv->month = tm->tm_mon;
+    priv->day = tm->tm_mday;
+
+    hildon_picker_button_set_selector_func (HILDON_PICKER_BUTTON (button),
+                                            hildon_date_button_create_selector);
+    hildon_date_button_show_date (button);
+  }
+
   return object;
 }
 
@@ -89,9 +160,9 @@ hildon_date_button_class_init (HildonDateButtonClass * klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->constructor = hildon_date_button_constructor;
-#if 0
-  g_type_class_add_private (klass, sizeof (HildonDateButtonPrivate));
 
+  g_type_class_add_private (klass, sizeof (HildonDateButtonPrivate));
+#if 0
   object_class->get_property = hildon_date_button_get_property;
   object_class->set_property = hildon_date_button_set_property;
 #endif
@@ -100,25 +171,10 @@ hildon_date_button_class_init (HildonDateButtonClass * klass)
 static void
 hildon_date_button_init (HildonDateButton * self)
 {
-  GtkWidget *date_selector;
-
-  date_selector = hildon_date_selector_new ();
+  HildonDateButtonPrivate *priv = GET_PRIVATE (self);
 
-  hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (self),
-                                     HILDON_TOUCH_SELECTOR (date_selector));
-}
-
-static GtkWidget *
-hildon_date_button_new_full (HildonSizeType           size,
-                             HildonButtonArrangement  arrangement,
-                             GtkWidget               *selector)
-{
-  return g_object_new (HILDON_TYPE_DATE_BUTTON,
-                       "title", HILDON_STOCK_DATE,
-                       "arrangement", arrangement,
-                       "size", size,
-                       "touch-selector", selector,
-                       NULL);
+  priv->min_year = -1;
+  priv->max_year = -1;
 }
 
 /**
@@ -137,8 +193,7 @@ GtkWidget *
 hildon_date_button_new (HildonSizeType          size,
                         HildonButtonArrangement arrangement)
 {
-  GtkWidget *selector = hildon_date_selector_new ();
-  return hildon_date_button_new_full (size, arrangement, selector);
+  return hildon_date_button_new_with_year_range (size, arrangement, -1, -1);
 }
 
 /**
@@ -161,9 +216,26 @@ hildon_date_button_new_with_year_range (HildonSizeType size,
                                         gint min_year,
                                         gint max_year)
 {
-  GtkWidget *selector;
-  selector = hildon_date_selector_new_with_year_range (min_year, max_year);
-  return hildon_date_button_new_full (size, arrangement, selector);
+  GtkWidget *button;
+  HildonDateButtonPrivate *priv;
+
+  /* The selector itself is built when first needed */
+  button = g_object_new (HILDON_TYPE_DATE_BUTTON,
+                         "title", HILDON_STOCK_DATE,
+                         "arrangement", arrangement,
+                         "size", size,
+                         NULL);
+
+  priv = GET_PRIVATE (button);
+  priv->min_year = min_year;
+  priv->max_year = max_year;
+
+  /* Today is out of the range, show what the selector chooses instead */
+  if (!hildon_date_button_date_in_range (HILDON_DATE_BUTTON (button),
+                                         priv->year, priv->month, priv->day))
+    hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+
+  return button;
 }
 
 /**
@@ -182,10 +254,22 @@ hildon_date_button_get_date (HildonDateButton * button,
                              guint * year, guint * month, guint * day)
 {
   HildonTouchSelector *selector;
+  HildonDateButtonPrivate *priv;
 
   g_return_if_fail (HILDON_IS_DATE_BUTTON (button));
 
-  selector = hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+  selector = hildon_picker_button_peek_selector (HILDON_PICKER_BUTTON (button));
+
+  if (selector == NULL) {
+    priv = GET_PRIVATE (button);
+    if (year != NULL)
+      *year = priv->year;
+    if (month != NULL)
+      *month = priv->month;
+    if (day != NULL)
+      *day = priv->day;
+    return;
+  }
 
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
 
@@ -209,11 +293,26 @@ hildon_date_button_set_date (HildonDateButton * button,
                              guint year, guint month, guint day)
 {
   HildonTouchSelector *selector;
+  HildonDateButtonPrivate *priv;
   gchar *date;
 
   g_return_if_fail (HILDON_IS_DATE_BUTTON (button));
 
-  selector = hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+  selector = hildon_picker_button_peek_selector (HILDON_PICKER_BUTTON (button));
+
+  if (selector == NULL) {
+    priv = GET_PRIVATE (button);
+    if (hildon_date_button_date_in_range (button, year, month, day)) {
+      priv->year = year;
+      priv->month = month;
+      priv->day = day;
+      hildon_date_button_show_date (button);
+      hildon_picker_button_value_changed (HILDON_PICKER_BUTTON (button));
+      return;
+    }
+    /* Let the selector complain about it */
+    selector = hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+  }
 
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (selector));
 
@@ -48,6 +48,9 @@
 #include <langinfo.h>
 
 #include "hildon-date-selector.h"
+#include "hildon-date-selector-private.h"
+#include "hildon-touch-selector-private.h"
+#include "hildon-date-time-models-private.h"
 
 #define HILDON_DATE_SELECTOR_GET_PRIVATE(obj)                           \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_DATE_SELECTOR, HildonDateSelectorPrivate))
@@ -63,8 +66,8 @@ G_DEFINE_TYPE (HildonDateSelector, hildon_date_selector, HILDON_TYPE_TOUCH_SELEC
 
 enum
 {
-  COLUMN_STRING,
-  COLUMN_INT,
+  COLUMN_STRING = HILDON_DATE_TIME_MODEL_COLUMN_STRING,
+  COLUMN_INT = HILDON_DATE_TIME_MODEL_COLUMN_INT,
   N_COLUMNS
 };
 
@@ -79,7 +82,7 @@ struct _HildonDateSelectorPrivate
 {
   GtkTreeModel *year_model;
   GtkTreeModel *month_model;
-  GtkTreeModel *day_model;
+  GtkTreeModel *day_model;      /* filters the shared 31 day model */
 
   GSList *column_order;
   gint day_column;
@@ -110,8 +113,6 @@ static void hildon_date_selector_finalize (GObject * object);
 
 /* private functions */
 static GtkTreeModel *_create_day_model (HildonDateSelector * selector);
-static GtkTreeModel *_create_year_model (HildonDateSelector * selector);
-static GtkTreeModel *_create_month_model (HildonDateSelector * selector);
 
 static void _get_real_date (gint * year, gint * month, gint * day);
 static void _locales_init (HildonDateSelectorPrivate * priv);
@@ -272,7 +273,7 @@ hildon_date_selector_class_init (HildonDateSelectorClass * class)
       "The minimum available year in the selector",
       1900,
       2100,
-      1970,
+      HILDON_DATE_SELECTOR_DEFAULT_MIN_YEAR,
       G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE));
 
   g_object_class_install_property (
@@ -284,7 +285,7 @@ hildon_date_selector_class_init (HildonDateSelectorClass * class)
       "The maximum available year in the selector",
       1900,
       2100,
-      2037,
+      HILDON_DATE_SELECTOR_DEFAULT_MAX_YEAR,
       G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE));
 
   /* signals */
@@ -299,8 +300,10 @@ hildon_date_selector_construct_ui (HildonDateSelector *selector)
   gint current_item = 0;
   HildonTouchSelectorColumn *column = NULL;
 
-  selector->priv->year_model = _create_year_model (selector);
-  selector->priv->month_model = _create_month_model (selector);
+  selector->priv->year_model =
+    hildon_date_time_models_get_years (selector->priv->min_year,
+                                       selector->priv->max_year);
+  selector->priv->month_model = hildon_date_time_models_get_months ();
   selector->priv->day_model = _create_day_model (selector);
 
   /* We add the columns, checking the locale order */
@@ -411,27 +414,13 @@ static gchar *
 _custom_print_func (HildonTouchSelector * touch_selector, gpointer user_data)
 {
   HildonDateSelector *selector = NULL;
-  gchar *result = NULL;
   guint year, month, day;
-  gint day_of_week = 0;
-  static gchar string[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
   selector = HILDON_DATE_SELECTOR (touch_selector);
 
   hildon_date_selector_get_date (selector, &year, &month, &day);
-  day_of_week = _day_of_week (year, month + 1, day) % 7;
-
-  tm.tm_mday = day;
-  tm.tm_mon = month;
-  tm.tm_year = year - 1900;
-  tm.tm_wday = day_of_week;
-
-  strftime (string, 255, _("wdgt_va_date_long"), &tm);
 
-  result = g_strdup (string);
-
-  return result;
+  return hildon_date_selector_format_date (year, month, day);
 }
 
 /* This was copied from hildon-calendar */
@@ -526,82 +515,37 @@ _init_column_order (HildonDateSelector * selector)
 }
 
 
-static GtkTreeModel *
-_create_day_model (HildonDateSelector * selector)
+static gboolean
+_day_visible_func (GtkTreeModel *model,
+                   GtkTreeIter  *iter,
+                   gpointer      data)
 {
-  GtkListStore *store_days = NULL;
-  gint i = 0;
-  gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  GtkTreeIter iter;
+  HildonDateSelector *selector = HILDON_DATE_SELECTOR (data);
+  gint day = 0;
 
-  store_days = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = 1; i < 32; i++) {
-    tm.tm_mday = i;
-    strftime (label, 255, _("wdgt_va_day_numeric"), &tm);
+  gtk_tree_model_get (model, iter, COLUMN_INT, &day, -1);
 
-    gtk_list_store_append (store_days, &iter);
-    gtk_list_store_set (store_days, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, i, -1);
-  }
-
-  return GTK_TREE_MODEL (store_days);
+  return day <= selector->priv->current_num_days;
 }
 
 static GtkTreeModel *
-_create_year_model (HildonDateSelector * selector)
+_create_day_model (HildonDateSelector * selector)
 {
-  GtkListStore *store_years = NULL;
-  gint i = 0;
-  static gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  GtkTreeIter iter;
-
-  store_years = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = selector->priv->min_year; i < selector->priv->max_year + 1; i++) {
-    tm.tm_year = i - 1900;
-    strftime (label, 255, _("wdgt_va_year"), &tm);
+  GtkTreeModel *filter = NULL;
 
-    gtk_list_store_append (store_years, &iter);
-    gtk_list_store_set (store_years, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, i, -1);
-  }
+  /* The labels are shared with the other selectors, only the number
+   * of days of the current month is per instance */
+  filter = hildon_date_time_models_get_days ();
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          _day_visible_func, selector, NULL);
 
-  return GTK_TREE_MODEL (store_years);
-}
-
-static GtkTreeModel *
-_create_month_model (HildonDateSelector * selector)
-{
-  GtkTreeIter iter;
-  gint i = 0;
-  GtkListStore *store_months = NULL;
-  static gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-
-  store_months = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = 0; i < 12; i++) {
-    tm.tm_mon = i;
-    strftime (label, 255, _("wdgt_va_month"), &tm);
-
-    gtk_list_store_append (store_months, &iter);
-    gtk_list_store_set (store_months, &iter, COLUMN_STRING, label,
-                        COLUMN_INT, i,
-                        -1);
-  }
-
-  return GTK_TREE_MODEL (store_months);
+  return filter;
 }
 
 static GtkTreeModel *
 _update_day_model (HildonDateSelector * selector)
 {
-  GtkListStore *store_days = NULL;
-  GtkTreePath *path = NULL;
-  gint i = 0;
   GtkTreeIter iter;
-  static gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
   guint current_day = 0;
   guint current_year = 0;
   guint current_month = 0;
@@ -611,42 +555,30 @@ _update_day_model (HildonDateSelector * selector)
                                  &current_day);
 
   num_days = _month_days (current_month, current_year);
-  store_days = GTK_LIST_STORE (selector->priv->day_model);
 
   if (num_days == selector->priv->current_num_days) {
-    return GTK_TREE_MODEL (store_days);
+    return selector->priv->day_model;
   }
 
-  if (num_days > selector->priv->current_num_days) {
-    for (i = selector->priv->current_num_days + 1; i <= num_days; i++) {
-      tm.tm_mday = i;
-      strftime (label, 255, _("wdgt_va_day_numeric"), &tm);
-
-      gtk_list_store_append (store_days, &iter);
-      gtk_list_store_set (store_days, &iter,
-                          COLUMN_STRING, label, COLUMN_INT, i, -1);
-    }
-  } else {
-    path = gtk_tree_path_new_from_indices (num_days,
-                                           -1);
-    gtk_tree_model_get_iter (GTK_TREE_MODEL (store_days), &iter, path);
-    do {
-    }while (gtk_list_store_remove (store_days, &iter));
-
-    gtk_tree_path_free (path);
+  /* Move the selection first, so the selected day is never hidden
+   * and the touch selector has no reason to select another one */
+  if (current_day > num_days) {
+    gtk_tree_model_iter_nth_child (selector->priv->day_model, &iter, NULL,
+                                   num_days - 1);
+    hildon_touch_selector_select_iter (HILDON_TOUCH_SELECTOR (selector),
+                                       selector->priv->day_column, &iter,
+                                       FALSE);
   }
 
-
+  /* Hiding or showing the last days emits a row signal for each one,
+   * the date only changed once, if at all, and that was already
+   * notified above */
+  hildon_touch_selector_block_changed (HILDON_TOUCH_SELECTOR (selector));
   selector->priv->current_num_days = num_days;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (selector->priv->day_model));
+  hildon_touch_selector_unblock_changed (HILDON_TOUCH_SELECTOR (selector));
 
-  /* now we select a day */
-  if (current_day >= num_days) {
-    current_day = num_days;
-  }
-
-  hildon_date_selector_select_day (selector, current_day);
-
-  return GTK_TREE_MODEL (store_days);
+  return selector->priv->day_model;
 }
 
 
@@ -707,6 +639,23 @@ _month_days (gint month, gint year)
 }
 
 
+/* Formats a date the way the selector prints it, without building one */
+G_GNUC_INTERNAL gchar *
+hildon_date_selector_format_date (guint year, guint month, guint day)
+{
+  gchar string[255];
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  tm.tm_mday = day;
+  tm.tm_mon = month;
+  tm.tm_year = year - 1900;
+  tm.tm_wday = _day_of_week (year, month + 1, day) % 7;
+
+  strftime (string, 255, _("wdgt_va_date_long"), &tm);
+
+  return g_strdup (string);
+}
+
 /* ------------------------------ PUBLIC METHODS ---------------------------- */
 
 /**
@@ -0,0 +1,64 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_DATE_TIME_MODELS_PRIVATE_H__
+#define                                         __HILDON_DATE_TIME_MODELS_PRIVATE_H__
+
+#include                                        <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* Columns of every model returned below */
+enum
+{
+  HILDON_DATE_TIME_MODEL_COLUMN_STRING,
+  HILDON_DATE_TIME_MODEL_COLUMN_INT,
+  HILDON_DATE_TIME_MODEL_N_COLUMNS
+};
+
+/* All these return a new GtkTreeModelFilter on top of a store shared
+ * by every selector using the current locale and the same parameters.
+ * The filter belongs to the caller, who may set its visible function
+ * to hide rows. The store is freed along with its last filter. */
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_days                (void);
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_months              (void);
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_years               (gint     min_year,
+                                                 gint     max_year);
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_hours               (gboolean ampm_format);
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_minutes             (guint    minutes_step);
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_ampm                (void);
+
+G_END_DECLS
+
+#endif                                          /* __HILDON_DATE_TIME_MODELS_PRIVATE_H__ */
@@ -0,0 +1,271 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Column models of HildonDateSelector and HildonTimeSelector.
+ *
+ * Building them calls strftime() once per row, and a screen full of
+ * date and time buttons used to build one copy of each per selector.
+ * They are built once here instead, and shared for as long as any
+ * selector uses them. Selectors get their own GtkTreeModelFilter on
+ * top of a shared store, so that applications can't change the rows
+ * of the other selectors through hildon_touch_selector_get_model().
+ * The cache is keyed by the current locale as well as by the model
+ * parameters, as the startup wizard changes the locale at runtime.
+ */
+
+#ifdef                                          HAVE_CONFIG_H
+#include                                        <config.h>
+#endif
+
+#include                                        <locale.h>
+#include                                        <libintl.h>
+#include                                        <time.h>
+
+#include                                        "hildon-date-time-models-private.h"
+
+#define                                         _(String) dgettext("hildon-libs", String)
+
+#define                                         LABEL_SIZE 255
+
+typedef GtkTreeModel * (*ModelBuilder)          (gint first,
+                                                 gint second);
+
+static GHashTable *models = NULL;
+
+static GtkListStore *
+model_store_new                                 (void)
+{
+  return gtk_list_store_new (HILDON_DATE_TIME_MODEL_N_COLUMNS,
+                             G_TYPE_STRING, G_TYPE_INT);
+}
+
+static void
+model_store_append                              (GtkListStore *store,
+                                                 const gchar  *label,
+                                                 gint          value)
+{
+  gtk_list_store_insert_with_values (store, NULL, -1,
+                                     HILDON_DATE_TIME_MODEL_COLUMN_STRING, label,
+                                     HILDON_DATE_TIME_MODEL_COLUMN_INT, value,
+                                     -1);
+}
+
+/* The last filter on a store is gone */
+static void
+models_remove                                   (gpointer  key,
+                                                 GObject  *model)
+{
+  g_hash_table_remove (models, key);
+}
+
+static GtkTreeModel *
+models_lookup                                   (const gchar  *kind,
+                                                 gint          first,
+                                                 gint          second,
+                                                 ModelBuilder  builder)
+{
+  GtkTreeModel *model;
+  GtkTreeModel *filter;
+  gchar *key;
+
+  /* Labels come from strftime() and from the hildon-libs catalog */
+  key = g_strdup_printf ("%s:%d:%d:%s:%s", kind, first, second,
+                         setlocale (LC_TIME, NULL),
+                         setlocale (LC_MESSAGES, NULL));
+
+  /* The stores are owned by the filters, not by the cache */
+  if (G_UNLIKELY (models == NULL))
+    models = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  model = g_hash_table_lookup (models, key);
+  if (model == NULL) {
+    model = builder (first, second);
+    g_hash_table_insert (models, key, model);
+    g_object_weak_ref (G_OBJECT (model), (GWeakNotify) models_remove, key);
+  } else {
+    g_object_ref (model);
+    g_free (key);
+  }
+
+  filter = gtk_tree_model_filter_new (model, NULL);
+  g_object_unref (model);
+
+  return filter;
+}
+
+static GtkTreeModel *
+build_days                                      (gint first,
+                                                 gint second)
+{
+  GtkListStore *store = model_store_new ();
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  gchar label[LABEL_SIZE];
+  gint i;
+
+  for (i = 1; i < 32; i++) {
+    tm.tm_mday = i;
+    strftime (label, LABEL_SIZE, _("wdgt_va_day_numeric"), &tm);
+    model_store_append (store, label, i);
+  }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkTreeModel *
+build_months                                    (gint first,
+                                                 gint second)
+{
+  GtkListStore *store = model_store_new ();
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  gchar label[LABEL_SIZE];
+  gint i;
+
+  for (i = 0; i < 12; i++) {
+    tm.tm_mon = i;
+    strftime (label, LABEL_SIZE, _("wdgt_va_month"), &tm);
+    model_store_append (store, label, i);
+  }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkTreeModel *
+build_years                                     (gint min_year,
+                                                 gint max_year)
+{
+  GtkListStore *store = model_store_new ();
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  gchar label[LABEL_SIZE];
+  gint i;
+
+  for (i = min_year; i < max_year + 1; i++) {
+    tm.tm_year = i - 1900;
+    strftime (label, LABEL_SIZE, _("wdgt_va_year"), &tm);
+    model_store_append (store, label, i);
+  }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkTreeModel *
+build_hours                                     (gint ampm_format,
+                                                 gint second)
+{
+  static const gint range_12h[12] = {12, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11};
+  static const gint range_24h[24] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,
+                                     12,13,14,15,16,17,18,19,20,21,22,23};
+  GtkListStore *store = model_store_new ();
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  gchar label[LABEL_SIZE];
+  const gint *range;
+  const gchar *format;
+  gint num_elements;
+  gint i;
+
+  if (ampm_format) {
+    range = range_12h;
+    num_elements = G_N_ELEMENTS (range_12h);
+    format = _("wdgt_va_12h_hours");
+  } else {
+    range = range_24h;
+    num_elements = G_N_ELEMENTS (range_24h);
+    format = _("wdgt_va_24h_hours");
+  }
+
+  for (i = 0; i < num_elements; i++) {
+    tm.tm_hour = range[i];
+    strftime (label, LABEL_SIZE, format, &tm);
+    model_store_append (store, label, range[i]);
+  }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkTreeModel *
+build_minutes                                   (gint minutes_step,
+                                                 gint second)
+{
+  GtkListStore *store = model_store_new ();
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  gchar label[LABEL_SIZE];
+  gint i;
+
+  for (i = 0; i <= 59; i += minutes_step) {
+    tm.tm_min = i;
+    strftime (label, LABEL_SIZE, _("wdgt_va_minutes"), &tm);
+    model_store_append (store, label, i);
+  }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkTreeModel *
+build_ampm                                      (gint first,
+                                                 gint second)
+{
+  GtkListStore *store = model_store_new ();
+
+  model_store_append (store, _("wdgt_va_am"), 0);
+  model_store_append (store, _("wdgt_va_pm"), 1);
+
+  return GTK_TREE_MODEL (store);
+}
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_days                (void)
+{
+  return models_lookup ("days", 0, 0, build_days);
+}
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_months              (void)
+{
+  return models_lookup ("months", 0, 0, build_months);
+}
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_years               (gint     min_year,
+                                                 gint     max_year)
+{
+  return models_lookup ("years", min_year, max_year, build_years);
+}
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_hours               (gboolean ampm_format)
+{
+  return models_lookup ("hours", ampm_format ? 1 : 0, 0, build_hours);
+}
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_minutes             (guint    minutes_step)
+{
+  g_return_val_if_fail (minutes_step > 0, NULL);
+
+  return models_lookup ("minutes", minutes_step, 0, build_minutes);
+}
+
+G_GNUC_INTERNAL GtkTreeModel *
+hildon_date_time_models_get_ampm                (void)
+{
+  return models_lookup ("ampm", 0, 0, build_ampm);
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Generates hildon-stripped-table.h, a two-level table that maps every
+ * character of the BMP to its stripped version, as returned by
+ * hildon_stripped_char_compute(). The first level maps the high byte
+ * of a character to a page of the second level, and identical pages
+ * are shared, which keeps the table at a few dozen kilobytes.
+ */
+
+#include                                        <stdio.h>
+#include                                        <string.h>
+#include                                        <glib.h>
+
+#include                                        "hildon-helper-private.h"
+
+#define                                         N_PAGES 256
+
+#define                                         PAGE_SIZE 256
+
+int
+main                                            (int argc,
+                                                 char **argv)
+{
+    static guint16 pages[N_PAGES][PAGE_SIZE];
+    guint8 index[N_PAGES];
+    guint n_pages = 0;
+    guint page, i;
+
+    for (page = 0; page < N_PAGES; page++) {
+        guint16 values[PAGE_SIZE];
+
+        for (i = 0; i < PAGE_SIZE; i++) {
+            gunichar sc = hildon_stripped_char_compute (page * PAGE_SIZE + i);
+            values[i] = sc < HILDON_STRIPPED_TABLE_UNCACHED ?
+                sc : HILDON_STRIPPED_TABLE_UNCACHED;
+        }
+
+        for (i = 0; i < n_pages; i++)
+            if (memcmp (pages[i], values, sizeof (values)) == 0)
+                break;
+
+        if (i == n_pages)
+            memcpy (pages[n_pages++], values, sizeof (values));
+
+        index[page] = i;
+    }
+
+    printf ("/* Generated by hildon-gen-stripped-table, do not edit */\n\n");
+
+    printf ("static const guint8 stripped_table_index[%d] = {", N_PAGES);
+    for (page = 0; page < N_PAGES; page++)
+        printf ("%s%3u,", page % 16 ? " " : "\n    ", index[page]);
+    printf ("\n};\n\n");
+
+    printf ("static const guint16 stripped_table_pages[%u][%d] = {\n",
+            n_pages, PAGE_SIZE);
+    for (page = 0; page < n_pages; page++) {
+        printf ("  {");
+        for (i = 0; i < PAGE_SIZE; i++)
+            printf ("%s0x%04x,", i % 8 ? " " : "\n    ", pages[page][i]);
+        printf ("\n  },\n");
+    }
+    printf ("};\n");
+
+    return 0;
+}
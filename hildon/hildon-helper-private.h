@@ -0,0 +1,71 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_HELPER_PRIVATE_H__
+#define                                         __HILDON_HELPER_PRIVATE_H__
+
+#include                                        <glib.h>
+
+G_BEGIN_DECLS
+
+/* Marks the characters of the stripped table that don't fit in it,
+ * U+FFFF itself is a noncharacter and is stripped to 0. */
+#define                                         HILDON_STRIPPED_TABLE_UNCACHED 0xffff
+
+/**
+ * hildon_stripped_char_compute:
+ *
+ * Returns a stripped version of @ch, removing any case, accentuation
+ * mark, or any special mark on it, or 0 if @ch should be ignored.
+ *
+ * This is the reference for the table generated by
+ * hildon-gen-stripped-table, which stripped_char() in hildon-helper.c
+ * uses for the BMP.
+ **/
+static inline gunichar
+hildon_stripped_char_compute                    (gunichar ch)
+{
+    gunichar decomp[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+
+    switch (g_unichar_type (ch)) {
+    case G_UNICODE_CONTROL:
+    case G_UNICODE_FORMAT:
+    case G_UNICODE_UNASSIGNED:
+    case G_UNICODE_COMBINING_MARK:
+        /* Ignore those */
+        return 0;
+    case G_UNICODE_LOWERCASE_LETTER:
+        break;
+    default:
+        ch = g_unichar_tolower (ch);
+        break;
+    }
+
+    if (g_unichar_fully_decompose (ch, FALSE, decomp, G_N_ELEMENTS (decomp)) > 0)
+        return decomp[0];
+
+    return 0;
+}
+
+G_END_DECLS
+
+#endif                                          /* __HILDON_HELPER_PRIVATE_H__ */
@@ -36,9 +36,21 @@
 #endif
 
 #define _GNU_SOURCE
+#include                                        <errno.h>
 #include                                        <string.h>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define                                         HAVE_SMART_MATCH_SSE2 1
+#include                                        <emmintrin.h>
+#elif defined (__GNUC__) && defined (__ARM_NEON)
+#define                                         HAVE_SMART_MATCH_NEON 1
+#include                                        <arm_neon.h>
+#endif
+
 #include                                        "hildon-helper.h"
+#include                                        "hildon-helper-private.h"
 #include                                        "hildon-banner.h"
+#include                                        "hildon-stripped-table.h"
 
 #define                                         HILDON_FINGER_PRESSURE_THRESHOLD 0.4
 
@@ -460,37 +472,20 @@ hildon_format_file_size_for_display             (goffset size)
  *
  * Returns a stripped version of @ch, removing any case, accentuation
  * mark, or any special mark on it.
+ *
+ * Characters of the BMP are looked up in the table generated at build
+ * time by hildon-gen-stripped-table, the rest are computed.
  **/
-static gunichar
+static inline gunichar
 stripped_char (gunichar ch)
 {
-  gunichar *decomp, retval;
-  GUnicodeType utype;
-  gsize dlen;
-
-  utype = g_unichar_type (ch);
-
-  switch (utype) {
-  case G_UNICODE_CONTROL:
-  case G_UNICODE_FORMAT:
-  case G_UNICODE_UNASSIGNED:
-  case G_UNICODE_COMBINING_MARK:
-    /* Ignore those */
-    return 0;
-    break;
-  default:
-    /* Convert to lowercase, fall through */
-    ch = g_unichar_tolower (ch);
-  case G_UNICODE_LOWERCASE_LETTER:
-    if ((decomp = g_unicode_canonical_decomposition (ch, &dlen))) {
-      retval = decomp[0];
-      g_free (decomp);
-      return retval;
-    }
-    break;
+  if (G_LIKELY (ch < 0x10000)) {
+    gunichar sc = stripped_table_pages[stripped_table_index[ch >> 8]][ch & 0xff];
+    if (G_LIKELY (sc != HILDON_STRIPPED_TABLE_UNCACHED))
+      return sc;
   }
 
-  return 0;
+  return hildon_stripped_char_compute (ch);
 }
 
 static gchar *
@@ -646,6 +641,54 @@ hildon_helper_strip_string (const gchar *string)
   return nuni;
 }
 
+static void
+normalize_converter_free                        (gpointer converter)
+{
+    g_iconv_close ((GIConv) converter);
+}
+
+/**
+ * normalize_get_converter:
+ *
+ * Each thread keeps its own converter to ASCII, opened the first time
+ * it normalizes a string that is not plain ASCII.
+ *
+ * Returns: the converter of the calling thread, or (GIConv) -1
+ **/
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GPrivate normalize_converter = G_PRIVATE_INIT (normalize_converter_free);
+#else
+static GStaticPrivate normalize_converter = G_STATIC_PRIVATE_INIT;
+#endif
+
+static GIConv
+normalize_get_converter                         (void)
+{
+    GIConv converter;
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    converter = g_private_get (&normalize_converter);
+#else
+    converter = g_static_private_get (&normalize_converter);
+#endif
+    if (converter)
+        return converter;
+
+    converter = g_iconv_open ("ascii//translit", "utf-8");
+    if (converter == (GIConv) -1) {
+        g_warning ("Cannot convert from UTF-8 to ASCII");
+        return converter;
+    }
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    g_private_set (&normalize_converter, converter);
+#else
+    g_static_private_set (&normalize_converter, converter, normalize_converter_free);
+#endif
+
+    return converter;
+}
+
 /**
  * hildon_helper_normalize_string:
  * @string: a string
@@ -653,16 +696,305 @@ hildon_helper_strip_string (const gchar *string)
  * Transform a string into an ascii equivalent representation.
  * This is necessary for hildon_helper_smart_match() to work properly.
  *
- * Returns: a newly allocated string.
+ * Returns: a newly allocated string, or %NULL if @string is not valid
+ * UTF-8.
  **/
 gchar *
 hildon_helper_normalize_string (const gchar *string)
 {
-    gchar *str = g_convert (string, -1, "ascii//translit", "utf-8", NULL, NULL, NULL);
+    gchar buffer[256];
+    gchar *str;
+    gssize len;
+
+    len = hildon_helper_normalize_string_to_buffer (string, buffer, sizeof (buffer));
+    if (len < 0)
+        return NULL;
+
+    if ((gsize) len < sizeof (buffer))
+        return g_memdup (buffer, len + 1);
+
+    str = g_malloc (len + 1);
+    hildon_helper_normalize_string_to_buffer (string, str, len + 1);
 
     return str;
 }
 
+/**
+ * hildon_helper_normalize_string_to_buffer:
+ * @string: a string
+ * @buffer: where to store the normalized string
+ * @buffer_size: the size of @buffer, in bytes
+ *
+ * Like hildon_helper_normalize_string(), but stores the result in
+ * @buffer instead of allocating it. This avoids any allocation when
+ * normalizing many strings, for instance when matching all the rows of
+ * a model.
+ *
+ * If the result does not fit in @buffer, it is truncated to
+ * @buffer_size - 1 bytes. The result is always nul-terminated, unless
+ * @buffer_size is 0. The rest of @string is still converted in order
+ * to return the full length, so a small @buffer does not make the
+ * conversion of a long non-ASCII string cheaper.
+ *
+ * Plain ASCII strings are copied as they are. Other strings are
+ * converted with an iconv descriptor that is kept open for each
+ * thread, so this function can be used from several threads.
+ *
+ * Returns: the length of the normalized string, which is greater or
+ * equal than @buffer_size if it was truncated, or -1 if @string is
+ * not valid UTF-8.
+ *
+ * Since: 3.0
+ **/
+gssize
+hildon_helper_normalize_string_to_buffer        (const gchar *string,
+                                                 gchar       *buffer,
+                                                 gsize        buffer_size)
+{
+    GIConv converter;
+    const gchar *p;
+    gchar scratch[64];
+    gchar *inbuf;
+    gsize inleft;
+    gsize room, written = 0, stored = 0;
+    gboolean truncated = FALSE;
+
+    g_return_val_if_fail (string != NULL, -1);
+    g_return_val_if_fail (buffer != NULL || buffer_size == 0, -1);
+
+    for (p = string; *p != '\0' && (guchar) *p < 0x80; p++)
+        ;
+
+    if (*p == '\0') {
+        if (buffer_size == 0)
+            return p - string;
+        return g_strlcpy (buffer, string, buffer_size);
+    }
+
+    converter = normalize_get_converter ();
+    if (converter == (GIConv) -1)
+        return -1;
+
+    /* Reset the state left by the last conversion, if it failed */
+    g_iconv (converter, NULL, NULL, NULL, NULL);
+
+    inbuf = (gchar *) string;
+    inleft = strlen (string);
+    room = buffer_size > 0 ? buffer_size - 1 : 0;
+
+    while (inleft > 0) {
+        gchar *outbuf = truncated ? scratch : buffer + written;
+        gsize outleft = truncated ? sizeof (scratch) : room - written;
+        gsize before = outleft;
+        gsize res;
+
+        res = g_iconv (converter, &inbuf, &inleft, &outbuf, &outleft);
+        written += before - outleft;
+
+        if (res == (gsize) -1) {
+            if (errno != E2BIG) {
+                if (buffer_size > 0)
+                    buffer[0] = '\0';
+                return -1;
+            }
+            /* Out of room, keep converting only to know the length */
+            if (!truncated) {
+                stored = written;
+                truncated = TRUE;
+            }
+        }
+    }
+
+    if (buffer_size > 0)
+        buffer[truncated ? stored : written] = '\0';
+
+    return written;
+}
+
+typedef const gchar *
+(*SmartMatchFunc)                               (const gchar *haystack,
+                                                 const gchar *needle,
+                                                 gsize        nlen);
+
+/**
+ * smart_match_scalar:
+ * @haystack: a non-empty string where to find a match
+ * @needle: what to find, starting with an alphanumeric character
+ * @nlen: the length of @needle
+ *
+ * Portable version of the word-start search done by
+ * hildon_helper_smart_match(). The full comparison is only done for
+ * word starts whose first character matches the one of @needle.
+ *
+ * Returns: the first match of @needle in @haystack, or %NULL
+ **/
+static const gchar *
+smart_match_scalar                              (const gchar *haystack,
+                                                 const gchar *needle,
+                                                 gsize        nlen)
+{
+    gchar first = g_ascii_tolower (needle[0]);
+    const gchar *p = haystack;
+
+    while (*p != '\0') {
+        while (*p != '\0' && !g_ascii_isalnum (*p))
+            p++;
+        if (g_ascii_tolower (*p) == first &&
+            g_ascii_strncasecmp (p + 1, needle + 1, nlen - 1) == 0)
+            return p;
+        while (g_ascii_isalnum (*p))
+            p++;
+    }
+
+    return NULL;
+}
+
+#ifdef HAVE_SMART_MATCH_SSE2
+/**
+ * smart_match_sse2:
+ *
+ * Same as smart_match_scalar(), but finds the word starts beginning
+ * with the first character of @needle 16 bytes at a time.
+ *
+ * Loads are 16-byte aligned, so they never cross a page boundary even
+ * if they read past the end of @haystack. The bytes before @haystack
+ * in the first block, and the ones after its terminating nul in the
+ * last one, are masked out.
+ **/
+__attribute__ ((target ("sse2")))
+static const gchar *
+smart_match_sse2                                (const gchar *haystack,
+                                                 const gchar *needle,
+                                                 gsize        nlen)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i fold = _mm_set1_epi8 (0x20);
+    const __m128i digit_lo = _mm_set1_epi8 ('0');
+    const __m128i digit_range = _mm_set1_epi8 (9);
+    const __m128i alpha_lo = _mm_set1_epi8 ('a');
+    const __m128i alpha_range = _mm_set1_epi8 (25);
+    const __m128i first = _mm_set1_epi8 (g_ascii_tolower (needle[0]));
+    gsize offset = (gsize) haystack & 15;
+    const gchar *block = haystack - offset;
+    guint valid = 0xffff << offset;
+    guint carry = 0;
+
+    for (;; block += 16, valid = 0xffff) {
+        __m128i chunk = _mm_load_si128 ((const __m128i *) block);
+        __m128i lower = _mm_or_si128 (chunk, fold);
+        __m128i d, a, is_digit, is_alpha;
+        guint alnum, nul, starts;
+
+        /* x is in [lo, lo + range] iff min (x - lo, range) == x - lo,
+         * using unsigned bytes */
+        d = _mm_sub_epi8 (chunk, digit_lo);
+        is_digit = _mm_cmpeq_epi8 (_mm_min_epu8 (d, digit_range), d);
+        a = _mm_sub_epi8 (lower, alpha_lo);
+        is_alpha = _mm_cmpeq_epi8 (_mm_min_epu8 (a, alpha_range), a);
+
+        alnum = _mm_movemask_epi8 (_mm_or_si128 (is_digit, is_alpha)) & valid;
+        nul = _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, zero)) & valid;
+
+        starts = alnum & ~((alnum << 1) | carry);
+        starts &= _mm_movemask_epi8 (_mm_cmpeq_epi8 (lower, first));
+        carry = (alnum >> 15) & 1;
+
+        if (nul)
+            starts &= (nul & -nul) - 1;
+
+        while (starts) {
+            const gchar *p = block + __builtin_ctz (starts);
+            if (g_ascii_strncasecmp (p + 1, needle + 1, nlen - 1) == 0)
+                return p;
+            starts &= starts - 1;
+        }
+
+        if (nul)
+            return NULL;
+    }
+}
+#endif
+
+#ifdef HAVE_SMART_MATCH_NEON
+/**
+ * smart_match_neon:
+ *
+ * NEON version of smart_match_sse2(). NEON has no byte movemask, so
+ * the comparison results are narrowed to a 64-bit mask holding four
+ * bits per byte.
+ **/
+static const gchar *
+smart_match_neon                                (const gchar *haystack,
+                                                 const gchar *needle,
+                                                 gsize        nlen)
+{
+    const uint8x16_t fold = vdupq_n_u8 (0x20);
+    const uint8x16_t digit_lo = vdupq_n_u8 ('0');
+    const uint8x16_t digit_range = vdupq_n_u8 (9);
+    const uint8x16_t alpha_lo = vdupq_n_u8 ('a');
+    const uint8x16_t alpha_range = vdupq_n_u8 (25);
+    const uint8x16_t first = vdupq_n_u8 (g_ascii_tolower (needle[0]));
+    gsize offset = (gsize) haystack & 15;
+    const gchar *block = haystack - offset;
+    guint64 valid = G_GUINT64_CONSTANT (0xffffffffffffffff) << (offset * 4);
+    guint64 carry = 0;
+
+#define NIBBLE_MASK(v) \
+    vget_lane_u64 (vreinterpret_u64_u8 (vshrn_n_u16 (vreinterpretq_u16_u8 (v), 4)), 0)
+
+    for (;; block += 16, valid = G_GUINT64_CONSTANT (0xffffffffffffffff)) {
+        uint8x16_t chunk = vld1q_u8 ((const guint8 *) block);
+        uint8x16_t lower = vorrq_u8 (chunk, fold);
+        uint8x16_t is_digit = vcleq_u8 (vsubq_u8 (chunk, digit_lo), digit_range);
+        uint8x16_t is_alpha = vcleq_u8 (vsubq_u8 (lower, alpha_lo), alpha_range);
+        guint64 alnum, nul, starts;
+
+        alnum = NIBBLE_MASK (vorrq_u8 (is_digit, is_alpha)) & valid;
+        nul = NIBBLE_MASK (vceqq_u8 (chunk, vdupq_n_u8 (0))) & valid;
+
+        starts = alnum & ~((alnum << 4) | carry);
+        starts &= NIBBLE_MASK (vceqq_u8 (lower, first));
+        carry = alnum >> 60;
+
+        if (nul)
+            starts &= (nul & -nul) - 1;
+
+        while (starts) {
+            gint i = __builtin_ctzll (starts) / 4;
+            const gchar *p = block + i;
+            if (g_ascii_strncasecmp (p + 1, needle + 1, nlen - 1) == 0)
+                return p;
+            starts &= ~(G_GUINT64_CONSTANT (0xf) << (i * 4));
+        }
+
+        if (nul)
+            return NULL;
+    }
+
+#undef NIBBLE_MASK
+}
+#endif
+
+static SmartMatchFunc
+smart_match_get_func                            (void)
+{
+    static gsize func = 0;
+
+    if (g_once_init_enter (&func)) {
+        SmartMatchFunc f = smart_match_scalar;
+#if defined (HAVE_SMART_MATCH_SSE2)
+        __builtin_cpu_init ();
+        if (__builtin_cpu_supports ("sse2"))
+            f = smart_match_sse2;
+#elif defined (HAVE_SMART_MATCH_NEON)
+        f = smart_match_neon;
+#endif
+        g_once_init_leave (&func, (gsize) f);
+    }
+
+    return (SmartMatchFunc) func;
+}
+
 /**
  * hildon_helper_smart_match:
  * @haystack: a string where to find a match
@@ -693,19 +1025,9 @@ hildon_helper_smart_match (const gchar *haystack, const gchar *needle)
     gboolean skip_separators = g_ascii_isalnum (needle[0]);
 
     if (skip_separators) {
-        gint i = 0;
-        while (haystack[i] != '\0') {
-            while (haystack[i] != '\0' && !g_ascii_isalnum (haystack[i]))
-                i++;
-            if (g_ascii_strncasecmp (haystack + i, needle, strlen (needle)) == 0) {
-                return (gchar *)haystack + i;
-            }
-            while (g_ascii_isalnum (haystack[i]))
-                   i++;
-        }
+        SmartMatchFunc match = smart_match_get_func ();
+        return (gchar *) match (haystack, needle, strlen (needle));
     } else {
         return strcasestr (haystack, needle);
     }
-
-    return NULL;
 }
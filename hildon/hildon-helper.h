@@ -61,6 +61,11 @@ hildon_helper_strip_string                      (const gchar *string);
 gchar *
 hildon_helper_normalize_string                  (const gchar *string);
 
+gssize
+hildon_helper_normalize_string_to_buffer        (const gchar *string,
+                                                 gchar       *buffer,
+                                                 gsize        buffer_size);
+
 gchar *
 hildon_helper_smart_match                       (const gchar *haystack,
                                                  const gchar *needle);
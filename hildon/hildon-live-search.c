@@ -40,6 +40,7 @@
 
 #include                                        <hildon/hildon.h>
 #include                                        <string.h>
+#include                                        <unistd.h>
 
 G_DEFINE_TYPE (HildonLiveSearch, hildon_live_search, GTK_TYPE_TOOLBAR);
 
@@ -48,6 +49,44 @@ G_DEFINE_TYPE (HildonLiveSearch, hildon_live_search, GTK_TYPE_TOOLBAR);
                                                 HILDON_TYPE_LIVE_SEARCH,           \
                                                 HildonLiveSearchPrivate))
 
+/* Models smaller than this are matched on the main thread even when
+ * #HildonLiveSearch:threaded is set, as dispatching is not worth it. */
+#define                                         THREADED_MIN_ROWS 4096
+
+/* Rows matched by a worker between two checks for cancellation */
+#define                                         THREADED_CHUNK_STEP 1024
+
+/* Refilters faster than about one frame, in microseconds, are run on
+ * the next idle without waiting for more keystrokes. */
+#define                                         DEBOUNCE_MIN_TIME 16000
+
+#define                                         DEFAULT_MAX_LATENCY 0
+
+typedef struct
+{
+    volatile gint ref_count;
+    guint n_rows;
+    gchar **rows;
+} HildonLiveSearchSnapshot;
+
+typedef struct
+{
+    HildonLiveSearch *livesearch;
+    HildonLiveSearchSnapshot *snapshot;
+    gchar *prefix;
+    guint8 *visible;
+    guint generation;
+    volatile gint cancelled;
+    volatile gint pending_chunks;
+} HildonLiveSearchJob;
+
+typedef struct
+{
+    HildonLiveSearchJob *job;
+    guint start;
+    guint end;
+} HildonLiveSearchChunk;
+
 struct _HildonLiveSearchPrivate
 {
     GtkTreeModelFilter *filter;
@@ -56,7 +95,10 @@ struct _HildonLiveSearchPrivate
 
     GtkWidget *entry;
     GtkWidget *event_widget;
-    GHashTable *selection_map;
+    GArray *selection_map;
+    GSList *selection_refs;
+    GtkTreeModel *selection_model;
+    gulong selection_handlers[3];
 
     gulong key_press_id;
     gulong event_widget_destroy_id;
@@ -71,6 +113,37 @@ struct _HildonLiveSearchPrivate
     GDestroyNotify visible_destroy;
     gboolean visible_func_set;
     gboolean run_async;
+
+    gboolean threaded;
+    gboolean in_refilter;
+    guint generation;
+    HildonLiveSearchSnapshot *snapshot;
+    GtkTreeModel *snapshot_model;
+    gulong snapshot_handlers[4];
+    HildonLiveSearchJob *job;
+    guint8 *visible_rows;
+    guint n_visible_rows;
+    guint visible_rows_generation;
+
+    gboolean indexed;
+    gboolean index_applied;
+    guint *prefix_index;
+    guint index_lo;
+    guint index_hi;
+    gboolean index_updating;
+    GtkTreeIter index_changed_iter;
+    gboolean index_changed_visible;
+
+    guint max_latency;
+    gint64 pending_since;
+    gint64 refilter_time;
+    gint64 job_start;
+
+    guint max_results;
+    guint results_limit;
+    guint n_results;
+    HildonSmartMatchIndex *match_index;
+    HildonSmartMatcher *matcher;
 };
 
 enum
@@ -80,7 +153,12 @@ enum
     PROP_FILTER,
     PROP_WIDGET,
     PROP_TEXT_COLUMN,
-    PROP_TEXT
+    PROP_TEXT,
+    PROP_THREADED,
+    PROP_INDEXED,
+    PROP_MAX_RESULTS,
+    PROP_MAX_LATENCY,
+    PROP_REFILTER_TIME
 };
 
 enum
@@ -96,40 +174,126 @@ visible_func                                    (GtkTreeModel *model,
                                                  GtkTreeIter  *iter,
                                                  gpointer      data);
 
+static void
+refilter                                        (HildonLiveSearch *livesearch);
+
 /* Private implementation */
 
-static guint
-hash_func                                       (gconstpointer key)
+static gint
+compare_row_index                               (gconstpointer a,
+                                                 gconstpointer b)
 {
-    GtkTreePath *path;
-    gchar *path_str;
-    guint val;
+    guint ia = *(const guint *) a;
+    guint ib = *(const guint *) b;
 
-    path = gtk_tree_row_reference_get_path ((GtkTreeRowReference *) key);
-    path_str = gtk_tree_path_to_string (path);
-    val = g_str_hash (path_str);
-    g_free (path_str);
-    gtk_tree_path_free (path);
-
-    return val;
+    return (ia > ib) - (ia < ib);
 }
 
+/**
+ * selection_map_lookup:
+ * @map: a sorted array of child model row indices
+ * @index: the row index to look for
+ *
+ * Binary search in the selection map.
+ *
+ * Returns: %TRUE if @index is in @map
+ **/
 static gboolean
-key_equal_func                                  (gconstpointer v1,
-                                                 gconstpointer v2)
+selection_map_lookup                            (GArray *map,
+                                                 guint   index)
 {
-    gboolean ret;
-    GtkTreePath *path1;
-    GtkTreePath *path2;
+    guint lo = 0, hi = map->len;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        guint val = g_array_index (map, guint, mid);
+
+        if (val == index)
+            return TRUE;
+        else if (val < index)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-    path1 = gtk_tree_row_reference_get_path ((GtkTreeRowReference *) v1);
-    path2 = gtk_tree_row_reference_get_path ((GtkTreeRowReference *) v2);
-    ret = gtk_tree_path_compare (path1, path2) == 0;
+    return FALSE;
+}
 
-    gtk_tree_path_free (path1);
-    gtk_tree_path_free (path2);
+static void
+on_selection_model_row_inserted                 (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GArray *map = priv->selection_map;
+    guint index, i;
 
-    return ret;
+    if (gtk_tree_path_get_depth (path) != 1)
+        return;
+
+    index = gtk_tree_path_get_indices (path)[0];
+
+    for (i = 0; i < map->len; i++) {
+        if (g_array_index (map, guint, i) >= index)
+            g_array_index (map, guint, i)++;
+    }
+}
+
+static void
+on_selection_model_row_deleted                  (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GArray *map = priv->selection_map;
+    guint index, i;
+
+    if (gtk_tree_path_get_depth (path) != 1)
+        return;
+
+    index = gtk_tree_path_get_indices (path)[0];
+
+    i = 0;
+    while (i < map->len) {
+        guint val = g_array_index (map, guint, i);
+
+        if (val == index) {
+            g_array_remove_index (map, i);
+        } else {
+            if (val > index)
+                g_array_index (map, guint, i) = val - 1;
+            i++;
+        }
+    }
+}
+
+static void
+on_selection_model_rows_reordered               (GtkTreeModel            *model,
+                                                 GtkTreePath             *path,
+                                                 GtkTreeIter             *iter,
+                                                 gint                    *new_order,
+                                                 HildonLiveSearchPrivate *priv)
+{
+    GArray *map = priv->selection_map;
+    guint *old_to_new;
+    gint n, i;
+
+    if (gtk_tree_path_get_depth (path) != 0)
+        return;
+
+    n = gtk_tree_model_iter_n_children (model, NULL);
+    old_to_new = g_new (guint, n);
+    for (i = 0; i < n; i++)
+        old_to_new[new_order[i]] = i;
+
+    for (i = 0; i < (gint) map->len; i++) {
+        guint val = g_array_index (map, guint, i);
+
+        if (val < (guint) n)
+            g_array_index (map, guint, i) = old_to_new[val];
+    }
+
+    g_array_sort (map, compare_row_index);
+    g_free (old_to_new);
 }
 
 /**
@@ -138,19 +302,38 @@ key_equal_func                                  (gconstpointer v1,
  *
  * Adds a selection map which is useful when merging selected rows in
  * a treeview, when the live search widget is used.
+ *
+ * The map is a sorted array with the indices of the selected toplevel
+ * rows in the child model of the filter. It is kept up to date with
+ * the changes in the child model, so that it survives insertions and
+ * removals without holding a #GtkTreeRowReference per row. Selected
+ * rows below the top level of hierarchical models are rare, those are
+ * kept as row references in priv->selection_refs.
  **/
 static void
 selection_map_create                            (HildonLiveSearchPrivate *priv)
 {
-    if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget))
+    GtkTreeModel *base_model;
+
+    if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget) || priv->filter == NULL)
         return;
 
     g_assert (priv->selection_map == NULL);
 
-    priv->selection_map = g_hash_table_new_full
-        (hash_func, key_equal_func,
-         (GDestroyNotify) gtk_tree_row_reference_free, NULL);
+    priv->selection_map = g_array_new (FALSE, FALSE, sizeof (guint));
 
+    base_model = gtk_tree_model_filter_get_model (priv->filter);
+    priv->selection_model = g_object_ref (base_model);
+
+    priv->selection_handlers[0] =
+        g_signal_connect (base_model, "row-inserted",
+                          G_CALLBACK (on_selection_model_row_inserted), priv);
+    priv->selection_handlers[1] =
+        g_signal_connect (base_model, "row-deleted",
+                          G_CALLBACK (on_selection_model_row_deleted), priv);
+    priv->selection_handlers[2] =
+        g_signal_connect (base_model, "rows-reordered",
+                          G_CALLBACK (on_selection_model_rows_reordered), priv);
 }
 
 /**
@@ -162,14 +345,28 @@ selection_map_create                            (HildonLiveSearchPrivate *priv)
 static void
 selection_map_destroy                           (HildonLiveSearchPrivate *priv)
 {
+    guint i;
+
     if (priv->selection_map != NULL) {
-        g_hash_table_destroy (priv->selection_map);
+        for (i = 0; i < G_N_ELEMENTS (priv->selection_handlers); i++) {
+            g_signal_handler_disconnect (priv->selection_model,
+                                         priv->selection_handlers[i]);
+            priv->selection_handlers[i] = 0;
+        }
+        g_object_unref (priv->selection_model);
+        priv->selection_model = NULL;
+
+        g_array_free (priv->selection_map, TRUE);
         priv->selection_map = NULL;
+
+        g_slist_foreach (priv->selection_refs, (GFunc) gtk_tree_row_reference_free, NULL);
+        g_slist_free (priv->selection_refs);
+        priv->selection_refs = NULL;
     }
 }
 
 static GtkTreePath *
-convert_child_path_to_path (GtkTreeModel *model,
+convert_path_to_child_path (GtkTreeModel *model,
                             GtkTreeModel *base_model,
                             GtkTreePath *path)
 {
@@ -181,69 +378,150 @@ convert_child_path_to_path (GtkTreeModel *model,
     return gtk_tree_path_copy (path);
 
   g_assert (GTK_IS_TREE_MODEL_SORT (model));
-  g_assert (gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT(model)) == base_model);
+  g_assert (gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (model)) == base_model);
 
-  return gtk_tree_model_sort_convert_child_path_to_path
+  return gtk_tree_model_sort_convert_path_to_child_path
       (GTK_TREE_MODEL_SORT (model), path);
 }
 
+/**
+ * view_path_to_base_path:
+ * @priv: The private pimpl
+ * @view_path: a path in the model of the treeview
+ *
+ * Returns: the path of the same row in the child model of the filter,
+ * or %NULL.
+ **/
 static GtkTreePath *
-convert_path_to_child_path (GtkTreeModel *model,
-                            GtkTreeModel *base_model,
-                            GtkTreePath *path)
+view_path_to_base_path                          (HildonLiveSearchPrivate *priv,
+                                                 GtkTreePath             *view_path)
 {
-  g_return_val_if_fail (model != NULL, NULL);
-  g_return_val_if_fail (base_model != NULL, NULL);
-  g_return_val_if_fail (path != NULL, NULL);
+    GtkTreePath *filter_path, *base_path;
 
-  if (model == base_model)
-    return gtk_tree_path_copy (path);
+    filter_path = convert_path_to_child_path (
+        gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
+        GTK_TREE_MODEL (priv->filter), view_path);
+    if (filter_path == NULL)
+        return NULL;
 
-  g_assert (GTK_IS_TREE_MODEL_SORT (model));
-  g_assert (gtk_tree_model_sort_get_model (GTK_TREE_MODEL_SORT (model)) == base_model);
+    base_path = gtk_tree_model_filter_convert_path_to_child_path
+        (priv->filter, filter_path);
+    gtk_tree_path_free (filter_path);
 
-  return gtk_tree_model_sort_convert_path_to_child_path
-      (GTK_TREE_MODEL_SORT (model), path);
+    return base_path;
 }
 
+/**
+ * base_iter_to_view_iter:
+ * @priv: The private pimpl
+ * @base_iter: an iter in the child model of the filter
+ * @view_iter: return location for the iter in the model of the treeview
+ *
+ * Returns: %TRUE if the row is currently visible in the treeview.
+ **/
 static gboolean
-row_reference_is_not_selected (GtkTreeRowReference *row_ref,
-                               gpointer value,
-                               HildonLiveSearchPrivate *priv)
-{
-  GtkTreeSelection *selection = gtk_tree_view_get_selection (
-      GTK_TREE_VIEW (priv->kb_focus_widget));
-  GtkTreePath *base_path = gtk_tree_row_reference_get_path (row_ref);
-  GtkTreePath *filter_path;
-
-  if (base_path == NULL) {
-      return TRUE;
-  }
-
-  filter_path = gtk_tree_model_filter_convert_child_path_to_path
-      (priv->filter, base_path);
-  GtkTreePath *view_path;
-  gboolean ret;
-
-  if (filter_path == NULL)
-    {
-      gtk_tree_path_free (base_path);
-      return FALSE;
+base_iter_to_view_iter                          (HildonLiveSearchPrivate *priv,
+                                                 GtkTreeIter             *base_iter,
+                                                 GtkTreeIter             *view_iter)
+{
+    GtkTreeModel *view_model;
+    GtkTreeIter filter_iter;
+
+    if (!gtk_tree_model_filter_convert_child_iter_to_iter (priv->filter,
+                                                           &filter_iter,
+                                                           base_iter))
+        return FALSE;
+
+    view_model = gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget));
+    if (view_model == GTK_TREE_MODEL (priv->filter)) {
+        *view_iter = filter_iter;
+        return TRUE;
     }
 
-  view_path = convert_child_path_to_path (
-      gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
-              GTK_TREE_MODEL (priv->filter), filter_path);
+    g_assert (GTK_IS_TREE_MODEL_SORT (view_model));
+
+    return gtk_tree_model_sort_convert_child_iter_to_iter
+        (GTK_TREE_MODEL_SORT (view_model), view_iter, &filter_iter);
+}
+
+/**
+ * row_index_to_view_iter:
+ * @priv: The private pimpl
+ * @index: a toplevel row index in the child model of the filter
+ * @view_iter: return location for the iter in the model of the treeview
+ *
+ * Returns: %TRUE if the row is currently visible in the treeview.
+ **/
+static gboolean
+row_index_to_view_iter                          (HildonLiveSearchPrivate *priv,
+                                                 guint                    index,
+                                                 GtkTreeIter             *view_iter)
+{
+    GtkTreeIter base_iter;
+
+    if (!gtk_tree_model_iter_nth_child (gtk_tree_model_filter_get_model (priv->filter),
+                                        &base_iter, NULL, index))
+        return FALSE;
+
+    return base_iter_to_view_iter (priv, &base_iter, view_iter);
+}
+
+/**
+ * row_reference_to_view_iter:
+ * @priv: The private pimpl
+ * @ref: a reference to a row in the child model of the filter
+ * @view_iter: return location for the iter in the model of the treeview
+ *
+ * Returns: %TRUE if the row is currently visible in the treeview.
+ **/
+static gboolean
+row_reference_to_view_iter                      (HildonLiveSearchPrivate *priv,
+                                                 GtkTreeRowReference     *ref,
+                                                 GtkTreeIter             *view_iter)
+{
+    GtkTreePath *base_path;
+    GtkTreeIter base_iter;
+    gboolean ret;
 
-  ret = ! gtk_tree_selection_path_is_selected (selection, view_path);
+    base_path = gtk_tree_row_reference_get_path (ref);
+    if (base_path == NULL)
+        return FALSE;
 
-  gtk_tree_path_free (base_path);
-  gtk_tree_path_free (filter_path);
-  gtk_tree_path_free (view_path);
+    ret = gtk_tree_model_get_iter (gtk_tree_model_filter_get_model (priv->filter),
+                                   &base_iter, base_path) &&
+        base_iter_to_view_iter (priv, &base_iter, view_iter);
+    gtk_tree_path_free (base_path);
 
-  return ret;
+    return ret;
 }
 
+/**
+ * selection_refs_lookup:
+ * @priv: The private pimpl
+ * @base_path: a path below the top level of the child model
+ *
+ * Returns: %TRUE if @base_path is in priv->selection_refs
+ **/
+static gboolean
+selection_refs_lookup                           (HildonLiveSearchPrivate *priv,
+                                                 GtkTreePath             *base_path)
+{
+    GSList *l;
+
+    for (l = priv->selection_refs; l != NULL; l = l->next) {
+        GtkTreePath *path = gtk_tree_row_reference_get_path (l->data);
+        gboolean found = FALSE;
+
+        if (path != NULL) {
+            found = gtk_tree_path_compare (path, base_path) == 0;
+            gtk_tree_path_free (path);
+        }
+        if (found)
+            return TRUE;
+    }
+
+    return FALSE;
+}
 
 /**
  * selection_map_update_map_from_selection:
@@ -255,54 +533,70 @@ row_reference_is_not_selected (GtkTreeRowReference *row_ref,
 static void
 selection_map_update_map_from_selection         (HildonLiveSearchPrivate *priv)
 {
-    GtkTreeModel *base_model;
     GtkTreeSelection *selection;
     GList *selected_list, *l_iter;
+    GSList *refs, *l;
+    GtkTreeModel *base_model;
+    GArray *map;
+    GtkTreeIter view_iter;
+    guint i, last;
 
     if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget))
         return;
 
-    base_model = gtk_tree_model_filter_get_model (priv->filter);
     selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (priv->kb_focus_widget));
+    base_model = gtk_tree_model_filter_get_model (priv->filter);
+    map = priv->selection_map;
 
-    /* Remove all items from priv->selection_map which are not selected */
-    g_hash_table_foreach_remove (priv->selection_map,
-                                 (GHRFunc) row_reference_is_not_selected, priv);
+    /* Keep only the rows that are filtered out, the treeview knows
+     * nothing about those. The visible ones are added back below if
+     * they are still selected. */
+    last = 0;
+    for (i = 0; i < map->len; i++) {
+        guint index = g_array_index (map, guint, i);
+
+        if (!row_index_to_view_iter (priv, index, &view_iter))
+            g_array_index (map, guint, last++) = index;
+    }
+    g_array_set_size (map, last);
+
+    refs = NULL;
+    for (l = priv->selection_refs; l != NULL; l = l->next) {
+        if (gtk_tree_row_reference_valid (l->data) &&
+            !row_reference_to_view_iter (priv, l->data, &view_iter))
+            refs = g_slist_prepend (refs, l->data);
+        else
+            gtk_tree_row_reference_free (l->data);
+    }
+    g_slist_free (priv->selection_refs);
+    priv->selection_refs = refs;
 
     /* fill priv->selection_map from gtk_tree_selection_get_selected_rows()*/
     selected_list = l_iter = gtk_tree_selection_get_selected_rows (selection,
                                                                  NULL);
     while (l_iter) {
         GtkTreePath *view_path = l_iter->data;
-        GtkTreePath *base_path, *filter_path;
-        GtkTreeRowReference *row_ref;
-
-        filter_path = convert_path_to_child_path (
-            gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
-            GTK_TREE_MODEL (priv->filter), view_path);
-        base_path = gtk_tree_model_filter_convert_path_to_child_path
-          (priv->filter, filter_path);
-
-        row_ref = gtk_tree_row_reference_new (base_model, base_path);
-        g_hash_table_replace (priv->selection_map,
-                              row_ref, NULL);
+        GtkTreePath *base_path = view_path_to_base_path (priv, view_path);
+
+        if (base_path != NULL) {
+            if (gtk_tree_path_get_depth (base_path) == 1) {
+                guint index = gtk_tree_path_get_indices (base_path)[0];
+                g_array_append_val (map, index);
+            } else {
+                priv->selection_refs = g_slist_prepend (
+                    priv->selection_refs,
+                    gtk_tree_row_reference_new (base_model, base_path));
+            }
+            gtk_tree_path_free (base_path);
+        }
+
         gtk_tree_path_free (view_path);
-        gtk_tree_path_free (filter_path);
-        gtk_tree_path_free (base_path);
-        selected_list->data = NULL;
         l_iter = g_list_next (l_iter);
     }
     g_list_free (selected_list);
-}
 
-static gboolean
-reference_row_has_path (GtkTreeRowReference *row_ref, gpointer value, GtkTreePath *path)
-{
-    gboolean ret;
-    GtkTreePath *path2 = gtk_tree_row_reference_get_path (row_ref);
-    ret = gtk_tree_path_compare (path, path2) == 0;
-    gtk_tree_path_free (path2);
-    return ret;
+    /* Hidden and selected rows are disjoint, so sorting is enough */
+    g_array_sort (map, compare_row_index);
 }
 
 /**
@@ -317,6 +611,9 @@ selection_map_update_selection_from_map         (HildonLiveSearchPrivate *priv)
 {
     GtkTreeSelection *selection;
     GList *selected_list, *l_iter;
+    GSList *l;
+    GtkTreeIter view_iter;
+    guint i;
 
     if (!GTK_IS_TREE_VIEW (priv->kb_focus_widget))
         return;
@@ -328,48 +625,720 @@ selection_map_update_selection_from_map         (HildonLiveSearchPrivate *priv)
                                                                  NULL);
     while (l_iter) {
         GtkTreePath *view_path = l_iter->data;
-        GtkTreePath *base_path, *filter_path;
-        filter_path = convert_path_to_child_path (
-            gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
-            GTK_TREE_MODEL (priv->filter), view_path);
-        base_path = gtk_tree_model_filter_convert_path_to_child_path
-            (priv->filter, filter_path);
-
-        if (g_hash_table_find (priv->selection_map,
-                               (GHRFunc) reference_row_has_path, base_path) == NULL)
-            gtk_tree_selection_unselect_path
-                (selection, view_path);
+        GtkTreePath *base_path = view_path_to_base_path (priv, view_path);
+        gboolean selected = FALSE;
+
+        if (base_path != NULL) {
+            if (gtk_tree_path_get_depth (base_path) == 1)
+                selected = selection_map_lookup (priv->selection_map,
+                                                 gtk_tree_path_get_indices (base_path)[0]);
+            else
+                selected = selection_refs_lookup (priv, base_path);
+            gtk_tree_path_free (base_path);
+        }
+
+        if (!selected)
+            gtk_tree_selection_unselect_path (selection, view_path);
+
+        gtk_tree_path_free (view_path);
+        l_iter = g_list_next (l_iter);
+    }
+    g_list_free (selected_list);
+
+    /* going though priv->selection_map to select items */
+    for (i = 0; i < priv->selection_map->len; i++) {
+        if (row_index_to_view_iter (priv,
+                                    g_array_index (priv->selection_map, guint, i),
+                                    &view_iter))
+            gtk_tree_selection_select_iter (selection, &view_iter);
+    }
+
+    for (l = priv->selection_refs; l != NULL; l = l->next) {
+        if (row_reference_to_view_iter (priv, l->data, &view_iter))
+            gtk_tree_selection_select_iter (selection, &view_iter);
+    }
+}
+
+static gboolean
+row_text_matches                                (const gchar *string,
+                                                 const gchar *prefix)
+{
+    return (string != NULL && g_str_has_prefix (string, prefix));
+}
+
+/**
+ * snapshot_new:
+ * @model: the child model of the filter
+ * @text_column: the column to copy
+ *
+ * Copies the strings of @text_column for the toplevel rows of @model
+ * into an immutable array that worker threads can read without
+ * touching the model.
+ **/
+static HildonLiveSearchSnapshot *
+snapshot_new                                    (GtkTreeModel *model,
+                                                 gint          text_column)
+{
+    HildonLiveSearchSnapshot *snapshot;
+    GtkTreeIter iter;
+    guint i = 0;
+
+    snapshot = g_slice_new (HildonLiveSearchSnapshot);
+    snapshot->ref_count = 1;
+    snapshot->n_rows = gtk_tree_model_iter_n_children (model, NULL);
+    snapshot->rows = g_new0 (gchar *, snapshot->n_rows + 1);
+
+    if (gtk_tree_model_get_iter_first (model, &iter)) {
+        do {
+            gtk_tree_model_get (model, &iter, text_column,
+                                &snapshot->rows[i], -1);
+            i++;
+        } while (i < snapshot->n_rows && gtk_tree_model_iter_next (model, &iter));
+    }
+
+    return snapshot;
+}
+
+static HildonLiveSearchSnapshot *
+snapshot_ref                                    (HildonLiveSearchSnapshot *snapshot)
+{
+    g_atomic_int_inc (&snapshot->ref_count);
+
+    return snapshot;
+}
+
+static void
+snapshot_unref                                  (HildonLiveSearchSnapshot *snapshot)
+{
+    if (g_atomic_int_dec_and_test (&snapshot->ref_count)) {
+        g_strfreev (snapshot->rows);
+        g_slice_free (HildonLiveSearchSnapshot, snapshot);
+    }
+}
+
+static void
+job_free                                        (HildonLiveSearchJob *job)
+{
+    snapshot_unref (job->snapshot);
+    g_object_unref (job->livesearch);
+    g_free (job->prefix);
+    g_free (job->visible);
+    g_slice_free (HildonLiveSearchJob, job);
+}
+
+/**
+ * threaded_cancel:
+ * @priv: The private pimpl
+ *
+ * Marks the job in flight, if any, as stale. Its workers stop at
+ * their next check and its result is dropped when it reaches the
+ * main loop.
+ **/
+static void
+threaded_cancel                                 (HildonLiveSearchPrivate *priv)
+{
+    if (priv->job != NULL) {
+        g_atomic_int_set (&priv->job->cancelled, TRUE);
+        priv->job = NULL;
+    }
+    priv->job_start = 0;
+}
+
+/**
+ * threaded_invalidate:
+ * @priv: The private pimpl
+ *
+ * Forgets the visibility computed for the previous text, so that it
+ * is never applied to the filter again.
+ **/
+static void
+threaded_invalidate                             (HildonLiveSearchPrivate *priv)
+{
+    priv->generation++;
+    threaded_cancel (priv);
+}
+
+static void
+snapshot_drop                                   (HildonLiveSearchPrivate *priv)
+{
+    guint i;
+
+    if (priv->snapshot_model != NULL) {
+        for (i = 0; i < G_N_ELEMENTS (priv->snapshot_handlers); i++) {
+            g_signal_handler_disconnect (priv->snapshot_model,
+                                         priv->snapshot_handlers[i]);
+            priv->snapshot_handlers[i] = 0;
+        }
+        g_object_unref (priv->snapshot_model);
+        priv->snapshot_model = NULL;
+    }
+
+    if (priv->snapshot != NULL) {
+        snapshot_unref (priv->snapshot);
+        priv->snapshot = NULL;
+    }
+
+    if (priv->match_index != NULL) {
+        hildon_smart_match_index_free (priv->match_index);
+        priv->match_index = NULL;
+    }
+
+    /* Laid out after the rows of the snapshot */
+    g_free (priv->prefix_index);
+    priv->prefix_index = NULL;
+    priv->index_applied = FALSE;
+
+    g_free (priv->visible_rows);
+    priv->visible_rows = NULL;
+    priv->n_visible_rows = 0;
+}
+
+static void
+on_snapshot_model_changed                       (HildonLiveSearch *livesearch)
+{
+    /* The filter already asked visible_func() about the rows that
+     * changed; we only need to stop trusting the copy. */
+    snapshot_drop (livesearch->priv);
+    threaded_invalidate (livesearch->priv);
+}
+
+static void
+snapshot_watch                                  (HildonLiveSearch *livesearch);
+
+static void
+snapshot_take                                   (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    GtkTreeModel *model;
+
+    g_assert (priv->snapshot == NULL);
+
+    model = gtk_tree_model_filter_get_model (priv->filter);
+
+    priv->snapshot = snapshot_new (model, priv->text_column);
+
+    snapshot_watch (livesearch);
+}
+
+/**
+ * snapshot_watch:
+ * @livesearch: A #HildonLiveSearch
+ *
+ * Makes sure that everything derived from the child model is dropped
+ * as soon as the model changes.
+ **/
+static void
+snapshot_watch                                  (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    GtkTreeModel *model;
+
+    if (priv->snapshot_model != NULL)
+        return;
+
+    model = gtk_tree_model_filter_get_model (priv->filter);
+    priv->snapshot_model = g_object_ref (model);
+
+    priv->snapshot_handlers[0] =
+        g_signal_connect_swapped (model, "row-changed",
+                                  G_CALLBACK (on_snapshot_model_changed), livesearch);
+    priv->snapshot_handlers[1] =
+        g_signal_connect_swapped (model, "row-inserted",
+                                  G_CALLBACK (on_snapshot_model_changed), livesearch);
+    priv->snapshot_handlers[2] =
+        g_signal_connect_swapped (model, "row-deleted",
+                                  G_CALLBACK (on_snapshot_model_changed), livesearch);
+    priv->snapshot_handlers[3] =
+        g_signal_connect_swapped (model, "rows-reordered",
+                                  G_CALLBACK (on_snapshot_model_changed), livesearch);
+}
+
+static gboolean
+on_job_done                                     (HildonLiveSearchJob *job)
+{
+    HildonLiveSearch *livesearch = job->livesearch;
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+
+    if (priv->job == job) {
+        priv->job = NULL;
+
+        if (job->generation == priv->generation) {
+            g_free (priv->visible_rows);
+            priv->visible_rows = job->visible;
+            priv->n_visible_rows = job->snapshot->n_rows;
+            priv->visible_rows_generation = job->generation;
+            job->visible = NULL;
+
+            refilter (livesearch);
+        }
+    }
+
+    job_free (job);
+
+    return FALSE;
+}
+
+static void
+match_chunk                                     (HildonLiveSearchChunk *chunk,
+                                                 gpointer               unused)
+{
+    HildonLiveSearchJob *job = chunk->job;
+    gchar **rows = job->snapshot->rows;
+    guint i;
+
+    for (i = chunk->start; i < chunk->end; i++) {
+        if ((i - chunk->start) % THREADED_CHUNK_STEP == 0 &&
+            g_atomic_int_get (&job->cancelled))
+            break;
+        job->visible[i] = row_text_matches (rows[i], job->prefix);
+    }
+
+    g_slice_free (HildonLiveSearchChunk, chunk);
+
+    if (g_atomic_int_dec_and_test (&job->pending_chunks))
+        gdk_threads_add_idle ((GSourceFunc) on_job_done, job);
+}
+
+static GThreadPool *
+get_thread_pool                                 (guint *n_threads)
+{
+    static GThreadPool *pool = NULL;
+    static guint n_cpus = 0;
+
+    if (G_UNLIKELY (pool == NULL)) {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+        n_cpus = g_get_num_processors ();
+#else
+        n_cpus = MAX (sysconf (_SC_NPROCESSORS_ONLN), 1);
+#endif
+        pool = g_thread_pool_new ((GFunc) match_chunk, NULL,
+                                  n_cpus, FALSE, NULL);
+    }
+
+    *n_threads = n_cpus;
+
+    return pool;
+}
+
+/**
+ * threaded_dispatch:
+ * @livesearch: A #HildonLiveSearch
+ *
+ * When #HildonLiveSearch:threaded applies, makes sure that the rows
+ * visible for the current text are being computed in the thread
+ * pool. refilter() is called again once they are available.
+ *
+ * Returns: %TRUE if refiltering has to wait for a worker job.
+ **/
+static gboolean
+threaded_dispatch                               (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    HildonLiveSearchJob *job;
+    GThreadPool *pool;
+    guint n_threads, chunk_size, start;
+
+    if (!priv->threaded || priv->indexed || priv->max_results > 0 ||
+        !priv->run_async ||
+        priv->filter == NULL || priv->prefix == NULL ||
+        priv->visible_func != NULL || priv->text_column == -1)
+        return FALSE;
+
+    if (priv->visible_rows != NULL &&
+        priv->visible_rows_generation == priv->generation)
+        return FALSE;
+
+    if (priv->job != NULL && priv->job->generation == priv->generation)
+        return TRUE;
+
+    threaded_cancel (priv);
+
+    if (priv->snapshot == NULL)
+        snapshot_take (livesearch);
+
+    if (priv->snapshot->n_rows < THREADED_MIN_ROWS)
+        return FALSE;
+
+    pool = get_thread_pool (&n_threads);
+    chunk_size = MAX (priv->snapshot->n_rows / n_threads + 1,
+                      THREADED_MIN_ROWS / 4);
+
+    job = g_slice_new0 (HildonLiveSearchJob);
+    job->livesearch = g_object_ref (livesearch);
+    job->snapshot = snapshot_ref (priv->snapshot);
+    job->prefix = g_strdup (priv->prefix);
+    job->visible = g_new0 (guint8, priv->snapshot->n_rows);
+    job->generation = priv->generation;
+    job->pending_chunks = (priv->snapshot->n_rows + chunk_size - 1) / chunk_size;
+
+    priv->job = job;
+
+    for (start = 0; start < priv->snapshot->n_rows; start += chunk_size) {
+        HildonLiveSearchChunk *chunk = g_slice_new (HildonLiveSearchChunk);
+
+        chunk->job = job;
+        chunk->start = start;
+        chunk->end = MIN (start + chunk_size, priv->snapshot->n_rows);
+        g_thread_pool_push (pool, chunk, NULL);
+    }
+
+    return TRUE;
+}
+
+static gint
+index_compare_rows                              (gconstpointer a,
+                                                 gconstpointer b,
+                                                 gpointer      data)
+{
+    gchar **rows = data;
+    const gchar *sa = rows[*(const guint *) a];
+    const gchar *sb = rows[*(const guint *) b];
+
+    if (sa == NULL || sb == NULL)
+        return (sa != NULL) - (sb != NULL);
+
+    return strcmp (sa, sb);
+}
+
+/**
+ * index_build:
+ * @priv: The private pimpl
+ *
+ * Sorts the rows of the snapshot by their text. Rows sharing a prefix
+ * are contiguous in that order, so looking them up is a matter of two
+ * binary searches.
+ **/
+static void
+index_build                                     (HildonLiveSearchPrivate *priv)
+{
+    guint i, n_rows = priv->snapshot->n_rows;
+
+    priv->prefix_index = g_new (guint, n_rows);
+    for (i = 0; i < n_rows; i++)
+        priv->prefix_index[i] = i;
+
+    g_qsort_with_data (priv->prefix_index, n_rows, sizeof (guint),
+                       index_compare_rows, priv->snapshot->rows);
+
+    priv->index_lo = priv->index_hi = 0;
+}
+
+/**
+ * index_lookup:
+ * @priv: The private pimpl
+ * @prefix: the prefix to look for
+ * @lo: return location for the first matching position in the index
+ * @hi: return location for the position after the last match
+ **/
+static void
+index_lookup                                    (HildonLiveSearchPrivate *priv,
+                                                 const gchar             *prefix,
+                                                 guint                   *lo,
+                                                 guint                   *hi)
+{
+    gchar **rows = priv->snapshot->rows;
+    gsize len = strlen (prefix);
+    guint first = 0, last = priv->snapshot->n_rows;
+
+    /* First row not sorting before @prefix */
+    while (first < last) {
+        guint mid = first + (last - first) / 2;
+        const gchar *s = rows[priv->prefix_index[mid]];
+
+        if (s == NULL || strcmp (s, prefix) < 0)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    *lo = first;
+
+    /* First row after that not starting with @prefix */
+    last = priv->snapshot->n_rows;
+    while (first < last) {
+        guint mid = first + (last - first) / 2;
+
+        if (strncmp (rows[priv->prefix_index[mid]], prefix, len) == 0)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    *hi = first;
+}
+
+/**
+ * index_update_rows:
+ * @priv: The private pimpl
+ * @from: first position in the index
+ * @to: position after the last one
+ * @visible: whether the rows are now visible
+ *
+ * Tells the filter that the visibility of the rows between @from and
+ * @to changed, by emitting #GtkTreeModel::row-changed on its child
+ * model for each of them.
+ **/
+static void
+index_update_rows                               (HildonLiveSearchPrivate *priv,
+                                                 guint                    from,
+                                                 guint                    to,
+                                                 gboolean                 visible)
+{
+    GtkTreeModel *model = gtk_tree_model_filter_get_model (priv->filter);
+    GtkTreePath *path;
+    guint i;
+
+    priv->index_changed_visible = visible;
+
+    for (i = from; i < to; i++) {
+        guint row = priv->prefix_index[i];
+
+        if (!gtk_tree_model_iter_nth_child (model, &priv->index_changed_iter,
+                                            NULL, row))
+            continue;
+
+        path = gtk_tree_path_new_from_indices (row, -1);
+        priv->index_updating = TRUE;
+        gtk_tree_model_row_changed (model, path, &priv->index_changed_iter);
+        priv->index_updating = FALSE;
+        gtk_tree_path_free (path);
+    }
+}
+
+/**
+ * index_query:
+ * @livesearch: A #HildonLiveSearch
+ * @needs_mapping: whether the selection of the treeview must be kept
+ *
+ * When #HildonLiveSearch:indexed applies, looks up the rows matching
+ * the current text in the prefix index. If the filter is showing the
+ * rows of the previous text, only the rows entering or leaving the
+ * matching range are updated, so a change of text costs two binary
+ * searches plus one row-changed emission per row that changes.
+ *
+ * Returns: %TRUE if the filter is up to date, %FALSE if it still has
+ * to be refiltered as a whole.
+ **/
+static gboolean
+index_query                                     (HildonLiveSearch *livesearch,
+                                                 gboolean          needs_mapping)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    gboolean was_applied;
+    guint lo, hi, old_lo, old_hi;
+
+    if (!priv->indexed || priv->max_results > 0 || priv->filter == NULL ||
+        priv->visible_func != NULL || priv->text_column == -1)
+        return FALSE;
+
+    was_applied = priv->index_applied;
+    priv->index_applied = FALSE;
+
+    /* Everything is visible, plain refiltering is as good as it gets */
+    if (priv->prefix == NULL)
+        return FALSE;
+
+    /* The application refilters the model on its own */
+    if (g_signal_has_handler_pending (livesearch, signals[REFILTER], 0, TRUE))
+        return FALSE;
+
+    if (priv->snapshot == NULL)
+        snapshot_take (livesearch);
+
+    if (priv->prefix_index == NULL) {
+        index_build (priv);
+        was_applied = FALSE;
+    }
+
+    old_lo = priv->index_lo;
+    old_hi = priv->index_hi;
+    index_lookup (priv, priv->prefix, &lo, &hi);
+
+    priv->index_lo = lo;
+    priv->index_hi = hi;
+    priv->index_applied = TRUE;
+
+    /* A full refilter matches the same rows as the index */
+    if (!was_applied)
+        return FALSE;
+
+    if (lo == old_lo && hi == old_hi)
+        return TRUE;
+
+    if (needs_mapping) {
+        if (priv->selection_map == NULL)
+            selection_map_create (priv);
+        selection_map_update_map_from_selection (priv);
+    }
+
+    /* The rows themselves didn't change, keep the index */
+    g_signal_handler_block (priv->snapshot_model, priv->snapshot_handlers[0]);
+    priv->in_refilter = TRUE;
+
+    index_update_rows (priv, old_lo, MIN (old_hi, lo), FALSE);
+    index_update_rows (priv, MAX (old_lo, hi), old_hi, FALSE);
+    index_update_rows (priv, lo, MIN (hi, old_lo), TRUE);
+    index_update_rows (priv, MAX (lo, old_hi), hi, TRUE);
+
+    priv->in_refilter = FALSE;
+    g_signal_handler_unblock (priv->snapshot_model, priv->snapshot_handlers[0]);
+
+    if (needs_mapping)
+        selection_map_update_selection_from_map (priv);
+
+    return TRUE;
+}
+
+typedef struct
+{
+    guint offset;
+    guint length;
+    guint row;
+} HildonLiveSearchRank;
+
+/* Best ranked first: earliest match, then shortest text, then model order */
+static gint
+rank_compare                                    (const HildonLiveSearchRank *a,
+                                                 const HildonLiveSearchRank *b)
+{
+    if (a->offset != b->offset)
+        return a->offset < b->offset ? -1 : 1;
+    if (a->length != b->length)
+        return a->length < b->length ? -1 : 1;
+
+    return (a->row > b->row) - (a->row < b->row);
+}
+
+/**
+ * rank_heap_push:
+ * @heap: a max-heap of the best ranks found so far, worst at the top
+ * @size: the number of elements in @heap
+ * @capacity: the number of ranks to keep
+ * @rank: a new rank
+ *
+ * Returns: the new size of @heap
+ **/
+static guint
+rank_heap_push                                  (HildonLiveSearchRank       *heap,
+                                                 guint                       size,
+                                                 guint                       capacity,
+                                                 const HildonLiveSearchRank *rank)
+{
+    guint i;
+
+    if (size < capacity) {
+        /* Sift up */
+        i = size++;
+        while (i > 0 && rank_compare (&heap[(i - 1) / 2], rank) < 0) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = *rank;
+    } else if (rank_compare (rank, &heap[0]) < 0) {
+        /* Replace the worst one and sift down */
+        i = 0;
+        while (2 * i + 1 < size) {
+            guint child = 2 * i + 1;
+
+            if (child + 1 < size && rank_compare (&heap[child + 1], &heap[child]) > 0)
+                child++;
+            if (rank_compare (&heap[child], rank) <= 0)
+                break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = *rank;
+    }
+
+    return size;
+}
+
+/**
+ * ranked_query:
+ * @livesearch: A #HildonLiveSearch
+ *
+ * When #HildonLiveSearch:max-results applies, finds the rows matching
+ * the current text in the smart match index and marks the best ranked
+ * ones as visible.
+ **/
+static void
+ranked_query                                    (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    HildonLiveSearchRank *heap;
+    GArray *candidates;
+    gchar **tokens;
+    gchar *first = NULL;
+    guint i, size, n_rows;
+
+    if (priv->max_results == 0 || priv->filter == NULL ||
+        priv->visible_func != NULL || priv->text_column == -1 ||
+        priv->prefix == NULL)
+        return;
+
+    if (priv->visible_rows != NULL &&
+        priv->visible_rows_generation == priv->generation)
+        return;
+
+    snapshot_watch (livesearch);
+
+    if (priv->match_index == NULL)
+        priv->match_index = hildon_smart_match_index_new
+            (gtk_tree_model_filter_get_model (priv->filter), priv->text_column);
+
+    candidates = hildon_smart_match_index_lookup (priv->match_index, priv->prefix);
 
-        gtk_tree_path_free (view_path);
-        gtk_tree_path_free (filter_path);
-        gtk_tree_path_free (base_path);
-        l_iter->data = NULL;
+    /* Rank on the first word typed */
+    tokens = g_strsplit (priv->prefix, " ", 2);
+    if (tokens[0] != NULL) {
+        gchar *normalized = hildon_helper_normalize_string (tokens[0]);
 
-        l_iter = g_list_next (l_iter);
+        if (normalized != NULL && normalized[0] != '\0')
+            first = g_ascii_strdown (normalized, -1);
+        g_free (normalized);
     }
-    g_list_free (selected_list);
+    g_strfreev (tokens);
 
-    /* going though priv->selection_map to select items */
-    GHashTableIter iter;
-    gpointer key, value;
-
-    g_hash_table_iter_init (&iter, priv->selection_map);
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        GtkTreeRowReference *row_ref = key;
-        GtkTreePath *base_path = gtk_tree_row_reference_get_path (row_ref);
-        GtkTreePath *filter_path = gtk_tree_model_filter_convert_child_path_to_path
-          (priv->filter, base_path);
-        GtkTreePath *view_path;
-
-        if (filter_path == NULL)
-            continue;
+    heap = g_new (HildonLiveSearchRank, MIN (priv->results_limit, candidates->len));
+    size = 0;
+
+    for (i = 0; i < candidates->len; i++) {
+        HildonLiveSearchRank rank;
+        const gchar *text, *match = NULL;
+
+        rank.row = g_array_index (candidates, guint, i);
+        text = hildon_smart_match_index_get_row_text (priv->match_index, rank.row);
+
+        if (first != NULL)
+            match = hildon_helper_smart_match (text, first);
 
-        view_path = convert_child_path_to_path (
-            gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)),
-            GTK_TREE_MODEL (priv->filter), filter_path);
+        rank.offset = match ? match - text : G_MAXUINT;
+        rank.length = text ? strlen (text) : 0;
 
-        gtk_tree_selection_select_path (selection, view_path);
+        size = rank_heap_push (heap, size,
+                               MIN (priv->results_limit, candidates->len), &rank);
     }
+
+    n_rows = hildon_smart_match_index_get_n_rows (priv->match_index);
+
+    g_free (priv->visible_rows);
+    priv->visible_rows = g_new0 (guint8, n_rows);
+    priv->n_visible_rows = n_rows;
+    for (i = 0; i < size; i++)
+        priv->visible_rows[heap[i].row] = TRUE;
+
+    priv->n_results = candidates->len;
+    priv->visible_rows_generation = priv->generation;
+
+    g_free (heap);
+    g_free (first);
+    g_array_free (candidates, TRUE);
+}
+
+static void
+refilter_done                                   (HildonLiveSearch *livesearch,
+                                                 gint64            start)
+{
+    livesearch->priv->refilter_time = g_get_monotonic_time () - start;
+    g_object_notify (G_OBJECT (livesearch), "refilter-time");
 }
 
 static void
@@ -378,8 +1347,10 @@ refilter (HildonLiveSearch *livesearch)
     HildonLiveSearchPrivate *priv = livesearch->priv;
     gboolean handled = FALSE;
     gboolean needs_mapping;
+    gint64 start = g_get_monotonic_time ();
 
-    needs_mapping = GTK_IS_TREE_VIEW (priv->kb_focus_widget) &&
+    needs_mapping = priv->filter != NULL &&
+        GTK_IS_TREE_VIEW (priv->kb_focus_widget) &&
         gtk_tree_selection_get_mode (gtk_tree_view_get_selection (
                                          GTK_TREE_VIEW (priv->kb_focus_widget))) != GTK_SELECTION_NONE;
 
@@ -388,6 +1359,28 @@ refilter (HildonLiveSearch *livesearch)
     if (needs_mapping && !gtk_tree_view_get_model (GTK_TREE_VIEW (priv->kb_focus_widget)))
         return;
 
+    /* Keep only the best ranked rows visible */
+    ranked_query (livesearch);
+
+    /* Update only the rows entering or leaving the matching range */
+    if (index_query (livesearch, needs_mapping)) {
+        refilter_done (livesearch, start);
+        return;
+    }
+
+    /* Wait for the worker threads, they will call us back */
+    if (threaded_dispatch (livesearch)) {
+        if (priv->job_start == 0)
+            priv->job_start = start;
+        return;
+    }
+
+    /* Count the time spent waiting for them too */
+    if (priv->job_start != 0) {
+        start = priv->job_start;
+        priv->job_start = 0;
+    }
+
     /* Create/update selection map from current selection */
     if (needs_mapping) {
         if (priv->selection_map == NULL)
@@ -396,13 +1389,17 @@ refilter (HildonLiveSearch *livesearch)
     }
 
     /* Filter the model */
+    priv->in_refilter = TRUE;
     g_signal_emit (livesearch, signals[REFILTER], 0, &handled);
     if (!handled && priv->filter)
         gtk_tree_model_filter_refilter (priv->filter);
+    priv->in_refilter = FALSE;
 
     /* Restore selection from mapping */
     if (needs_mapping)
         selection_map_update_selection_from_map (priv);
+
+    refilter_done (livesearch, start);
 }
 
 static gboolean
@@ -418,6 +1415,45 @@ on_idle_refilter (HildonLiveSearch *livesearch)
     return FALSE;
 }
 
+/**
+ * schedule_refilter:
+ * @livesearch: A #HildonLiveSearch
+ *
+ * Refilters on the next idle if refiltering is cheap. Otherwise waits
+ * as long as the last refilter took for more keystrokes to arrive,
+ * without delaying the oldest pending one more than
+ * #HildonLiveSearch:max-latency.
+ **/
+static void
+schedule_refilter                               (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv = livesearch->priv;
+    gint64 now = g_get_monotonic_time ();
+    gint64 delay;
+
+    if (priv->idle_filter_id == 0)
+        priv->pending_since = now;
+
+    if (priv->max_latency == 0 || priv->refilter_time < DEBOUNCE_MIN_TIME) {
+        if (priv->idle_filter_id == 0)
+            priv->idle_filter_id = gdk_threads_add_idle ((GSourceFunc) on_idle_refilter, livesearch);
+        return;
+    }
+
+    delay = MIN (priv->refilter_time,
+                 priv->pending_since + (gint64) priv->max_latency * 1000 - now);
+
+    if (priv->idle_filter_id != 0)
+        g_source_remove (priv->idle_filter_id);
+
+    if (delay <= 0)
+        priv->idle_filter_id = gdk_threads_add_idle ((GSourceFunc) on_idle_refilter, livesearch);
+    else
+        priv->idle_filter_id = gdk_threads_add_timeout (delay / 1000,
+                                                        (GSourceFunc) on_idle_refilter,
+                                                        livesearch);
+}
+
 static void
 on_entry_changed                                (GtkEntry *entry,
                                                  gpointer  user_data)
@@ -439,10 +1475,14 @@ on_entry_changed                                (GtkEntry *entry,
     g_free (priv->prefix);
     priv->prefix = g_strdup (text);
 
+    hildon_smart_matcher_free (priv->matcher);
+    priv->matcher = NULL;
+
+    threaded_invalidate (priv);
+    priv->results_limit = priv->max_results;
+
     if (priv->run_async) {
-        if (priv->idle_filter_id == 0) {
-            priv->idle_filter_id = gdk_threads_add_idle ((GSourceFunc) on_idle_refilter, livesearch);
-        }
+        schedule_refilter (livesearch);
     } else {
         if (priv->idle_filter_id != 0) {
             g_source_remove (priv->idle_filter_id);
@@ -610,6 +1650,21 @@ hildon_live_search_get_property                 (GObject    *object,
     case PROP_TEXT:
         g_value_set_string (value, livesearch->priv->prefix);
         break;
+    case PROP_THREADED:
+        g_value_set_boolean (value, livesearch->priv->threaded);
+        break;
+    case PROP_INDEXED:
+        g_value_set_boolean (value, livesearch->priv->indexed);
+        break;
+    case PROP_MAX_RESULTS:
+        g_value_set_uint (value, livesearch->priv->max_results);
+        break;
+    case PROP_MAX_LATENCY:
+        g_value_set_uint (value, livesearch->priv->max_latency);
+        break;
+    case PROP_REFILTER_TIME:
+        g_value_set_uint (value, hildon_live_search_get_refilter_time (livesearch));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -636,6 +1691,22 @@ hildon_live_search_set_property                 (GObject      *object,
         hildon_live_search_set_text (livesearch,
                                      g_value_get_string (value));
         break;
+    case PROP_THREADED:
+        hildon_live_search_set_threaded (livesearch,
+                                         g_value_get_boolean (value));
+        break;
+    case PROP_INDEXED:
+        hildon_live_search_set_indexed (livesearch,
+                                        g_value_get_boolean (value));
+        break;
+    case PROP_MAX_RESULTS:
+        hildon_live_search_set_max_results (livesearch,
+                                            g_value_get_uint (value));
+        break;
+    case PROP_MAX_LATENCY:
+        hildon_live_search_set_max_latency (livesearch,
+                                            g_value_get_uint (value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     }
@@ -648,6 +1719,9 @@ hildon_live_search_dispose                      (GObject *object)
 
     hildon_live_search_widget_unhook (HILDON_LIVE_SEARCH (object));
 
+    snapshot_drop (priv);
+    threaded_invalidate (priv);
+
     if (priv->filter) {
         selection_map_destroy (priv);
         g_object_unref (priv->filter);
@@ -659,6 +1733,9 @@ hildon_live_search_dispose                      (GObject *object)
         priv->prefix = NULL;
     }
 
+    hildon_smart_matcher_free (priv->matcher);
+    priv->matcher = NULL;
+
     if (priv->visible_destroy) {
         priv->visible_destroy (priv->visible_data);
         priv->visible_destroy = NULL;
@@ -735,6 +1812,104 @@ hildon_live_search_class_init                   (HildonLiveSearchClass *klass)
                                                        G_PARAM_READWRITE |
                                                        G_PARAM_STATIC_STRINGS));
 
+    /**
+     * HildonLiveSearch:threaded:
+     *
+     * Whether the default filtering function matches the rows of
+     * #HildonLiveSearch:text-column in worker threads. See
+     * hildon_live_search_set_threaded().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_THREADED,
+                                     g_param_spec_boolean ("threaded",
+                                                           "Threaded",
+                                                           "Whether to match rows "
+                                                           "in worker threads",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE |
+                                                           G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:indexed:
+     *
+     * Whether the default filtering function looks up the rows of
+     * #HildonLiveSearch:text-column in a sorted prefix index. See
+     * hildon_live_search_set_indexed().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_INDEXED,
+                                     g_param_spec_boolean ("indexed",
+                                                           "Indexed",
+                                                           "Whether to look up rows "
+                                                           "in a sorted prefix index",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE |
+                                                           G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:max-results:
+     *
+     * The maximum number of rows the default filtering function shows
+     * at once, or 0 for no limit. See
+     * hildon_live_search_set_max_results().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_MAX_RESULTS,
+                                     g_param_spec_uint ("max-results",
+                                                        "Maximum results",
+                                                        "Maximum number of best "
+                                                        "ranked rows to show",
+                                                        0, G_MAXUINT, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:max-latency:
+     *
+     * The maximum time, in milliseconds, that refiltering is delayed
+     * while the user keeps typing, or 0 to refilter on every change,
+     * which is the default. See hildon_live_search_set_max_latency().
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_MAX_LATENCY,
+                                     g_param_spec_uint ("max-latency",
+                                                        "Maximum latency",
+                                                        "Maximum time to delay "
+                                                        "refiltering, in milliseconds",
+                                                        0, G_MAXUINT, DEFAULT_MAX_LATENCY,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * HildonLiveSearch:refilter-time:
+     *
+     * The time, in microseconds, that the last refilter took. This
+     * includes restoring the selection of the tree view, if any, and
+     * waiting for the worker threads when #HildonLiveSearch:threaded
+     * applies.
+     * Connect to #GObject::notify for this property to get the time of
+     * each refilter.
+     *
+     * Since: 3.0
+     */
+    g_object_class_install_property (object_class,
+                                     PROP_REFILTER_TIME,
+                                     g_param_spec_uint ("refilter-time",
+                                                        "Refilter time",
+                                                        "Time the last refilter took, "
+                                                        "in microseconds",
+                                                        0, G_MAXUINT, 0,
+                                                        G_PARAM_READABLE |
+                                                        G_PARAM_STATIC_STRINGS));
+
   /**
    * HildonLiveSearch::refilter:
    * @livesearch: the object which received the signal
@@ -791,8 +1966,37 @@ hildon_live_search_init                         (HildonLiveSearch *self)
     priv->idle_filter_id = 0;
 
     priv->selection_map = NULL;
+    priv->selection_refs = NULL;
+    priv->selection_model = NULL;
     priv->run_async = TRUE;
 
+    priv->threaded = FALSE;
+    priv->in_refilter = FALSE;
+    priv->generation = 0;
+    priv->snapshot = NULL;
+    priv->snapshot_model = NULL;
+    priv->job = NULL;
+    priv->visible_rows = NULL;
+    priv->n_visible_rows = 0;
+
+    priv->indexed = FALSE;
+    priv->index_applied = FALSE;
+    priv->prefix_index = NULL;
+    priv->index_lo = 0;
+    priv->index_hi = 0;
+    priv->index_updating = FALSE;
+
+    priv->max_latency = DEFAULT_MAX_LATENCY;
+    priv->pending_since = 0;
+    priv->refilter_time = 0;
+    priv->job_start = 0;
+
+    priv->max_results = 0;
+    priv->results_limit = 0;
+    priv->n_results = 0;
+    priv->match_index = NULL;
+    priv->matcher = NULL;
+
     priv->text_column = -1;
 
     entry_container = gtk_tool_item_new ();
@@ -869,6 +2073,7 @@ visible_func                                    (GtkTreeModel *model,
     HildonLiveSearchPrivate *priv;
     gchar *string;
     gboolean visible = FALSE;
+    gint index = -1;
 
     priv = (HildonLiveSearchPrivate *) data;
 
@@ -882,10 +2087,39 @@ visible_func                                    (GtkTreeModel *model,
         visible = (priv->visible_func) (model, iter,
                                         priv->prefix,
                                         priv->visible_data);
+    } else if (priv->index_updating &&
+               iter->stamp == priv->index_changed_iter.stamp &&
+               iter->user_data == priv->index_changed_iter.user_data &&
+               iter->user_data2 == priv->index_changed_iter.user_data2 &&
+               iter->user_data3 == priv->index_changed_iter.user_data3) {
+        /* A row entering or leaving the range of the prefix index */
+        visible = priv->index_changed_visible;
     } else {
-        gtk_tree_model_get (model, iter, priv->text_column, &string, -1);
-        visible = (string != NULL && g_str_has_prefix (string, priv->prefix));
-        g_free (string);
+        /* Rows already matched by the worker threads can be looked up,
+         * but only while we are refiltering: the filter also calls us
+         * for rows being changed, before we notice the model changed. */
+        if (priv->in_refilter && priv->visible_rows != NULL &&
+            priv->visible_rows_generation == priv->generation) {
+            GtkTreePath *path = gtk_tree_model_get_path (model, iter);
+
+            if (gtk_tree_path_get_depth (path) == 1)
+                index = gtk_tree_path_get_indices (path)[0];
+            gtk_tree_path_free (path);
+        }
+
+        if (index >= 0 && (guint) index < priv->n_visible_rows) {
+            visible = priv->visible_rows[index];
+        } else {
+            gtk_tree_model_get (model, iter, priv->text_column, &string, -1);
+            if (priv->max_results > 0) {
+                /* Rows that are not in the index yet */
+                if (priv->matcher == NULL)
+                    priv->matcher = hildon_smart_matcher_new (priv->prefix);
+                visible = hildon_smart_matcher_match (priv->matcher, string);
+            } else
+                visible = row_text_matches (string, priv->prefix);
+            g_free (string);
+        }
     }
 
     return visible;
@@ -917,11 +2151,16 @@ hildon_live_search_set_filter                   (HildonLiveSearch   *livesearch,
     if (filter)
         g_object_ref (filter);
 
-    if (priv->filter)
+    if (priv->filter) {
+        selection_map_destroy (priv);
         g_object_unref (priv->filter);
+    }
 
     priv->filter = filter;
 
+    snapshot_drop (priv);
+    threaded_invalidate (priv);
+
     if (priv->visible_func_set == FALSE &&
         (priv->text_column != -1 || priv->visible_func)) {
         gtk_tree_model_filter_set_visible_func (filter,
@@ -991,6 +2230,9 @@ hildon_live_search_set_text_column              (HildonLiveSearch *livesearch,
 
     priv->text_column = text_column;
 
+    snapshot_drop (priv);
+    threaded_invalidate (priv);
+
     if (priv->visible_func_set == FALSE) {
         gtk_tree_model_filter_set_visible_func (priv->filter,
                                                 visible_func,
@@ -1228,3 +2470,318 @@ hildon_live_search_clean_selection_map (HildonLiveSearch * livesearch)
         selection_map_update_map_from_selection (livesearch->priv);
     }
 }
+
+/**
+ * hildon_live_search_set_threaded:
+ * @livesearch: a #HildonLiveSearch
+ * @threaded: whether to match rows in worker threads
+ *
+ * Sets whether the default filtering function, the one based on
+ * #HildonLiveSearch:text-column, matches the rows in worker threads.
+ *
+ * When enabled, @livesearch copies the strings of the text column
+ * into an immutable array the first time the text changes and
+ * splits the matching of that array across the available
+ * processors. The resulting visibility of each row is then applied
+ * to the #GtkTreeModelFilter in the main loop. If the text changes
+ * again before the workers are done, their results are discarded.
+ * The copy is dropped whenever the child model changes.
+ *
+ * This is only worth it for large, flat models. Rows that are not
+ * at the top level of the child model, models with few rows, and
+ * filters using hildon_live_search_set_visible_func() are always
+ * matched in the main thread. Matching results are the same in both
+ * modes.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_set_threaded                 (HildonLiveSearch *livesearch,
+                                                 gboolean          threaded)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+
+    priv = livesearch->priv;
+    threaded = threaded ? TRUE : FALSE;
+
+    if (priv->threaded == threaded)
+        return;
+
+    priv->threaded = threaded;
+
+    if (!threaded) {
+        snapshot_drop (priv);
+        threaded_invalidate (priv);
+    }
+
+    g_object_notify (G_OBJECT (livesearch), "threaded");
+}
+
+/**
+ * hildon_live_search_get_threaded:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Gets whether @livesearch matches rows in worker threads. See
+ * hildon_live_search_set_threaded().
+ *
+ * Returns: the value of #HildonLiveSearch:threaded
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_live_search_get_threaded                 (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
+
+    return livesearch->priv->threaded;
+}
+
+/**
+ * hildon_live_search_set_indexed:
+ * @livesearch: a #HildonLiveSearch
+ * @indexed: whether to use a prefix index
+ *
+ * Sets whether the default filtering function, the one based on
+ * #HildonLiveSearch:text-column, looks up matching rows in a sorted
+ * index instead of comparing the text of every row.
+ *
+ * The index is built from a copy of the text column the first time
+ * the text changes, and is dropped whenever the child model changes.
+ * Each change of the text then costs two binary searches instead of a
+ * string comparison per row, and only the rows that start or stop
+ * matching are updated in the filter. Those are announced with
+ * #GtkTreeModel::row-changed on the child model, which other views of
+ * that model see too. The filter is refiltered as a whole the first
+ * time the index is used, after the text is cleared, and whenever a
+ * #HildonLiveSearch::refilter handler is connected.
+ *
+ * Only the toplevel rows of the child model are indexed. The index
+ * takes precedence over #HildonLiveSearch:threaded, and matching
+ * results are the same in all modes.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_set_indexed                  (HildonLiveSearch *livesearch,
+                                                 gboolean          indexed)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+
+    priv = livesearch->priv;
+    indexed = indexed ? TRUE : FALSE;
+
+    if (priv->indexed == indexed)
+        return;
+
+    priv->indexed = indexed;
+
+    snapshot_drop (priv);
+    threaded_invalidate (priv);
+
+    g_object_notify (G_OBJECT (livesearch), "indexed");
+}
+
+/**
+ * hildon_live_search_get_indexed:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Gets whether @livesearch uses a prefix index. See
+ * hildon_live_search_set_indexed().
+ *
+ * Returns: the value of #HildonLiveSearch:indexed
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_live_search_get_indexed                  (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
+
+    return livesearch->priv->indexed;
+}
+
+/**
+ * hildon_live_search_set_max_results:
+ * @livesearch: a #HildonLiveSearch
+ * @max_results: the maximum number of rows to show, or 0
+ *
+ * Limits the number of rows shown by the default filtering function,
+ * the one based on #HildonLiveSearch:text-column. This is meant for
+ * very large models, where short texts match more rows than anybody
+ * will scroll through.
+ *
+ * When @max_results is not 0, rows are matched against each
+ * space-separated word of the text the same way #HildonTouchSelector
+ * does, using hildon_helper_smart_match() on normalized strings. Only
+ * the @max_results best ranked matches are kept visible: rows starting
+ * with the first word come first, then rows where it matches earlier,
+ * then shorter rows. Visible rows keep the order of the model.
+ *
+ * Use hildon_live_search_show_more_results() to show the next
+ * @max_results matches for the current text.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_set_max_results              (HildonLiveSearch *livesearch,
+                                                 guint             max_results)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+
+    priv = livesearch->priv;
+
+    if (priv->max_results == max_results)
+        return;
+
+    priv->max_results = max_results;
+    priv->results_limit = max_results;
+
+    snapshot_drop (priv);
+    threaded_invalidate (priv);
+
+    if (priv->filter != NULL)
+        refilter (livesearch);
+
+    g_object_notify (G_OBJECT (livesearch), "max-results");
+}
+
+/**
+ * hildon_live_search_get_max_results:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Returns: the value of #HildonLiveSearch:max-results
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_live_search_get_max_results              (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), 0);
+
+    return livesearch->priv->max_results;
+}
+
+/**
+ * hildon_live_search_show_more_results:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Shows #HildonLiveSearch:max-results more of the rows matching the
+ * current text, if there are any. The limit goes back to
+ * #HildonLiveSearch:max-results when the text changes.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_show_more_results            (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+
+    priv = livesearch->priv;
+
+    if (!hildon_live_search_has_more_results (livesearch))
+        return;
+
+    priv->results_limit += priv->max_results;
+    threaded_invalidate (priv);
+    refilter (livesearch);
+}
+
+/**
+ * hildon_live_search_has_more_results:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Returns: %TRUE if #HildonLiveSearch:max-results is hiding some of
+ * the rows matching the current text
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_live_search_has_more_results             (HildonLiveSearch *livesearch)
+{
+    HildonLiveSearchPrivate *priv;
+
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), FALSE);
+
+    priv = livesearch->priv;
+
+    return (priv->max_results > 0 && priv->prefix != NULL &&
+            priv->visible_rows != NULL &&
+            priv->visible_rows_generation == priv->generation &&
+            priv->n_results > priv->results_limit);
+}
+
+/**
+ * hildon_live_search_set_max_latency:
+ * @livesearch: a #HildonLiveSearch
+ * @max_latency: the maximum delay, in milliseconds, or 0
+ *
+ * Sets how long @livesearch may wait for the user to stop typing
+ * before refiltering.
+ *
+ * As long as refiltering is quick, @livesearch refilters on the next
+ * idle after each change of the text. When refiltering takes longer
+ * than about a frame, every new keystroke delays it by the time the
+ * last refilter took, so that fast typing causes a single refilter.
+ * The first change that is still pending is never delayed more than
+ * @max_latency milliseconds. If @max_latency is 0, the default,
+ * refiltering is never delayed.
+ *
+ * See #HildonLiveSearch:refilter-time to tune this value for a given
+ * model size.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_live_search_set_max_latency              (HildonLiveSearch *livesearch,
+                                                 guint             max_latency)
+{
+    g_return_if_fail (HILDON_IS_LIVE_SEARCH (livesearch));
+
+    if (livesearch->priv->max_latency == max_latency)
+        return;
+
+    livesearch->priv->max_latency = max_latency;
+
+    g_object_notify (G_OBJECT (livesearch), "max-latency");
+}
+
+/**
+ * hildon_live_search_get_max_latency:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Returns: the value of #HildonLiveSearch:max-latency
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_live_search_get_max_latency              (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), 0);
+
+    return livesearch->priv->max_latency;
+}
+
+/**
+ * hildon_live_search_get_refilter_time:
+ * @livesearch: a #HildonLiveSearch
+ *
+ * Returns: the time, in microseconds, that the last refilter of
+ * @livesearch took. See #HildonLiveSearch:refilter-time.
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_live_search_get_refilter_time            (HildonLiveSearch *livesearch)
+{
+    g_return_val_if_fail (HILDON_IS_LIVE_SEARCH (livesearch), 0);
+
+    return (guint) MIN (livesearch->priv->refilter_time, G_MAXUINT);
+}
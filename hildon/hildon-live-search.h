@@ -141,6 +141,43 @@ hildon_live_search_set_visible_func              (HildonLiveSearch           *li
 void
 hildon_live_search_clean_selection_map           (HildonLiveSearch * livesearch);
 
+void
+hildon_live_search_set_threaded                  (HildonLiveSearch *livesearch,
+                                                  gboolean          threaded);
+
+gboolean
+hildon_live_search_get_threaded                  (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_indexed                   (HildonLiveSearch *livesearch,
+                                                  gboolean          indexed);
+
+gboolean
+hildon_live_search_get_indexed                   (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_max_results               (HildonLiveSearch *livesearch,
+                                                  guint             max_results);
+
+guint
+hildon_live_search_get_max_results               (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_show_more_results             (HildonLiveSearch *livesearch);
+
+gboolean
+hildon_live_search_has_more_results              (HildonLiveSearch *livesearch);
+
+void
+hildon_live_search_set_max_latency               (HildonLiveSearch *livesearch,
+                                                  guint             max_latency);
+
+guint
+hildon_live_search_get_max_latency               (HildonLiveSearch *livesearch);
+
+guint
+hildon_live_search_get_refilter_time             (HildonLiveSearch *livesearch);
+
 G_END_DECLS
 
 #endif                                          /* __HILDON_LIVE_SEARCH__ */
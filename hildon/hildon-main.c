@@ -70,6 +70,7 @@
 
 #include "hildon-main.h"
 #include "hildon-stock.h"
+#include "hildon-sound-private.h"
 
 #define GETTEXT_PACKAGE "hildon-libs"
 
@@ -117,6 +118,9 @@ hildon_init (void)
 
   /* Add Hildon stock items */
   gtk_stock_add_static (hildon_items, G_N_ELEMENTS (hildon_items));
+
+  /* Get the note sounds ready before the first note shows up */
+  hildon_sound_init ();
 }
 
 /**
@@ -50,6 +50,11 @@ struct                                          _HildonNotePrivate
     gchar *original_description;
     guint idle_handler;
 
+    /* Progress set with hildon_note_set_progress_fraction() */
+    gdouble progress_fraction;
+    gint64 progress_time;
+    guint progress_id;
+
   /* These strings stored for backwards compatibility */
     gchar *icon;
     gchar *stock_icon;
@@ -94,6 +94,7 @@
 #include                                        "hildon-note.h"
 #include                                        "hildon-defines.h"
 #include                                        "hildon-sound.h"
+#include                                        "hildon-sound-private.h"
 #include                                        "hildon-gtk.h"
 #include                                        "hildon-stock.h"
 #include                                        "hildon-enum-types.h"
@@ -103,11 +104,8 @@
 
 #define                                         HILDON_INFORMATION_NOTE_MARGIN 100
 
-#define                                         CONFIRMATION_SOUND_PATH \
-                                                "/usr/share/sounds/ui-confirmation_note.wav"
-
-#define                                         INFORMATION_SOUND_PATH \
-                                                "/usr/share/sounds/ui-information_note.wav"
+/* Progress updates are applied at most once every this many ms */
+#define                                         HILDON_NOTE_PROGRESS_INTERVAL 16
 
 static void 
 hildon_note_class_init                          (HildonNoteClass *class);
@@ -401,6 +399,9 @@ hildon_note_init                                (HildonNote *dialog)
     priv->icon = NULL;
     priv->stock_icon = NULL;
     priv->idle_handler = 0;
+    priv->progress_fraction = 0.0;
+    priv->progress_time = 0;
+    priv->progress_id = 0;
     priv->align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
 
     gtk_container_add (GTK_CONTAINER (priv->event_box), priv->align);
@@ -458,6 +459,10 @@ hildon_note_finalize                            (GObject *obj_self)
         g_source_remove (priv->idle_handler);
         priv->idle_handler = 0;
     }
+    if (priv->progress_id) {
+        g_source_remove (priv->progress_id);
+        priv->progress_id = 0;
+    }
 
     if (priv->progressbar)
         g_object_unref (priv->progressbar);
@@ -885,7 +890,8 @@ hildon_note_new_information                     (GtkWindow *parent,
  * @description: the action to cancel.
  * @progressbar: a pointer to #GtkProgressBar to be filled with the
  *   progressbar assigned to this note. Use this to set the fraction of
- *   progressbar done. This parameter can be %NULL as well, in which
+ *   progressbar done, or hildon_note_set_progress_fraction() if it is
+ *   updated often. This parameter can be %NULL as well, in which
  *   case plain text cancel note appears.
  *
  * Create a new cancel note with a progress bar. Cancel note has 
@@ -973,6 +979,77 @@ hildon_note_set_button_texts                    (HildonNote *note,
     }
 }
 
+static gboolean
+hildon_note_update_progress                     (gpointer data)
+{
+    HildonNotePrivate *priv = HILDON_NOTE_GET_PRIVATE (data);
+    GtkProgressBar *bar;
+    gdouble current;
+    gint width;
+
+    priv->progress_id = 0;
+    priv->progress_time = g_get_monotonic_time ();
+
+    if (priv->progressbar == NULL)
+        return FALSE;
+
+    bar = GTK_PROGRESS_BAR (priv->progressbar);
+    current = gtk_progress_bar_get_fraction (bar);
+    width = gtk_widget_get_allocated_width (priv->progressbar);
+
+    /* Setting the fraction only redraws the bar, but not even that
+       if the filled part would keep the same width */
+    if (width > 1 &&
+        (gint) (current * width) == (gint) (priv->progress_fraction * width))
+        return FALSE;
+
+    gtk_progress_bar_set_fraction (bar, priv->progress_fraction);
+
+    return FALSE;
+}
+
+/**
+ * hildon_note_set_progress_fraction:
+ * @note: a #HildonNote with a progress bar
+ * @fraction: fraction of the task that's been completed
+ *
+ * Sets the fraction of the progress bar of a note created with
+ * hildon_note_new_cancel_with_progress_bar(). This can be called at
+ * any rate, for instance from each iteration of a file copy: only
+ * the last fraction is applied, at most once per frame, and only if
+ * the bar would visibly change.
+ *
+ * Since: 3.0
+ */
+void
+hildon_note_set_progress_fraction               (HildonNote *note,
+                                                 gdouble fraction)
+{
+    HildonNotePrivate *priv;
+    gint64 elapsed;
+    guint delay;
+
+    g_return_if_fail (HILDON_IS_NOTE (note));
+
+    priv = HILDON_NOTE_GET_PRIVATE (note);
+    g_return_if_fail (priv->progressbar != NULL);
+
+    priv->progress_fraction = CLAMP (fraction, 0.0, 1.0);
+
+    if (priv->progress_id != 0)
+        return;
+
+    /* Run right before the next redraw, or once a frame has passed
+       since the last update */
+    elapsed = (g_get_monotonic_time () - priv->progress_time) / 1000;
+    delay = elapsed >= HILDON_NOTE_PROGRESS_INTERVAL ?
+        0 : HILDON_NOTE_PROGRESS_INTERVAL - elapsed;
+
+    priv->progress_id = gdk_threads_add_timeout_full (GDK_PRIORITY_REDRAW - 1, delay,
+                                                      hildon_note_update_progress,
+                                                      note, NULL);
+}
+
 static void
 on_show_cb                                      (GtkWidget *widget,
                                                  gpointer data)
@@ -993,12 +1070,12 @@ sound_handling                                  (gpointer data)
     switch (priv->note_n)
     {
         case HILDON_NOTE_TYPE_INFORMATION:
-            hildon_play_system_sound (INFORMATION_SOUND_PATH);
+            hildon_play_system_sound (HILDON_SOUND_INFORMATION_NOTE);
             break;
 
         case HILDON_NOTE_TYPE_CONFIRMATION:
         case HILDON_NOTE_TYPE_CONFIRMATION_BUTTON:
-            hildon_play_system_sound (CONFIRMATION_SOUND_PATH);
+            hildon_play_system_sound (HILDON_SOUND_CONFIRMATION_NOTE);
             break;
 
         default:
@@ -90,6 +90,10 @@ hildon_note_set_button_texts                    (HildonNote *note,
                                                  const gchar *text_ok,
                                                  const gchar *text_cancel);
 
+void
+hildon_note_set_progress_fraction               (HildonNote *note,
+                                                 gdouble fraction);
+
 /**
  * HildonNoteType:
  * @HILDON_NOTE_TYPE_CONFIRMATION: Standard confirmation note with 'Yes'
@@ -25,6 +25,16 @@ G_GNUC_INTERNAL void
 hildon_picker_button_disable_value_changed      (HildonPickerButton *button,
                                                  gboolean            disable);
 
+/* Returns a new floating selector for @button */
+typedef HildonTouchSelector * (*HildonPickerButtonSelectorFunc) (HildonPickerButton *button);
+
+G_GNUC_INTERNAL HildonTouchSelector *
+hildon_picker_button_peek_selector              (HildonPickerButton *button);
+
+G_GNUC_INTERNAL void
+hildon_picker_button_set_selector_func          (HildonPickerButton             *button,
+                                                 HildonPickerButtonSelectorFunc  func);
+
 G_END_DECLS
 
 #endif /* __HILDON_PICKER_BUTTON_PRIVATE__ */
@@ -71,6 +71,7 @@
 #include "hildon-picker-button.h"
 #include "hildon-picker-button-private.h"
 #include "hildon-picker-dialog.h"
+#include "hildon-stock.h"
 
 G_DEFINE_TYPE (HildonPickerButton, hildon_picker_button, HILDON_TYPE_BUTTON)
 
@@ -82,11 +83,32 @@ typedef struct _HildonPickerButtonPrivate HildonPickerButtonPrivate;
 struct _HildonPickerButtonPrivate
 {
   GtkWidget *selector;
-  GtkWidget *dialog;
+  GtkWidget *dialog;            /* shared dialog, only while presented */
   gchar *done_button_text;
   guint disable_value_changed : 1;
+
+  /* Builds the selector the first time it is needed */
+  HildonPickerButtonSelectorFunc selector_func;
+
+  guint prewarm : 1;
+  guint prewarm_queued : 1;
 };
 
+/* All the picker buttons of a toplevel borrow the same dialog, kept
+ * as data of the toplevel. Buttons outside a toplevel share another. */
+#define SHARED_DIALOG_KEY "hildon-picker-button-shared-dialog"
+#define BORROWER_KEY "hildon-picker-button-borrower"
+
+static GtkWidget *unparented_dialog = NULL;
+
+/* Number of shared dialogs that may be prepared ahead of time in the
+ * whole process, each one holds a realized toplevel window */
+#define PREWARM_BUDGET 8
+
+static GQueue prewarm_queue = G_QUEUE_INIT;
+static guint prewarm_idle_id = 0;
+static guint prewarm_budget = PREWARM_BUDGET;
+
 /* Signals */
 enum
 {
@@ -97,7 +119,8 @@ enum
 enum
 {
   PROP_SELECTOR = 1,
-  PROP_DONE_BUTTON_TEXT
+  PROP_DONE_BUTTON_TEXT,
+  PROP_PREWARM
 };
 
 static guint picker_button_signals[LAST_SIGNAL] = { 0 };
@@ -114,6 +137,9 @@ static void
 hildon_picker_button_selector_columns_changed   (HildonTouchSelector * selector,
                                                  gpointer user_data);
 
+static void
+hildon_picker_button_return_dialog              (HildonPickerButton *button);
+
 
 static void
 hildon_picker_button_get_property (GObject * object, guint property_id,
@@ -128,6 +154,10 @@ hildon_picker_button_get_property (GObject * object, guint property_id,
     g_value_set_string (value,
                         hildon_picker_button_get_done_button_text (HILDON_PICKER_BUTTON (object)));
     break;
+  case PROP_PREWARM:
+    g_value_set_boolean (value,
+                         hildon_picker_button_get_prewarm (HILDON_PICKER_BUTTON (object)));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -146,6 +176,10 @@ hildon_picker_button_set_property (GObject * object, guint property_id,
     hildon_picker_button_set_done_button_text (HILDON_PICKER_BUTTON (object),
                                                g_value_get_string (value));
     break;
+  case PROP_PREWARM:
+    hildon_picker_button_set_prewarm (HILDON_PICKER_BUTTON (object),
+                                      g_value_get_boolean (value));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -158,6 +192,14 @@ hildon_picker_button_finalize (GObject * object)
 
   priv = GET_PRIVATE (object);
 
+  if (priv->prewarm_queued)
+    g_queue_remove (&prewarm_queue, object);
+
+  if (priv->dialog) {
+    gtk_widget_hide (priv->dialog);
+    hildon_picker_button_return_dialog (HILDON_PICKER_BUTTON (object));
+  }
+
   if (priv->selector) {
     g_signal_handlers_disconnect_by_func (priv->selector,
                                           hildon_picker_button_selector_selection_changed,
@@ -168,10 +210,6 @@ hildon_picker_button_finalize (GObject * object)
     g_object_unref (priv->selector);
     priv->selector = NULL;
   }
-  if (priv->dialog) {
-    gtk_widget_destroy (priv->dialog);
-    priv->dialog = NULL;
-  }
 
   if (priv->done_button_text) {
     g_free (priv->done_button_text);
@@ -249,45 +287,110 @@ hildon_picker_button_on_dialog_response (GtkDialog *dialog,
   }
 
   gtk_widget_hide (GTK_WIDGET (dialog));
+
+  hildon_picker_button_return_dialog (button);
 }
 
-static void
-hildon_picker_button_clicked (GtkButton * button)
+static GtkWidget *
+hildon_picker_button_get_shared_dialog (HildonPickerButton *button)
 {
   GtkWidget *parent;
-  HildonPickerButtonPrivate *priv;
+  GtkWidget *dialog;
 
-  priv = GET_PRIVATE (HILDON_PICKER_BUTTON (button));
+  parent = gtk_widget_get_toplevel (GTK_WIDGET (button));
+  if (gtk_widget_is_toplevel (parent)) {
+    dialog = g_object_get_data (G_OBJECT (parent), SHARED_DIALOG_KEY);
+  } else {
+    parent = NULL;
+    dialog = unparented_dialog;
+  }
 
-  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (priv->selector));
+  if (dialog == NULL) {
+    dialog = hildon_picker_dialog_new (GTK_WINDOW (parent));
+    g_signal_connect (dialog, "delete-event",
+                      G_CALLBACK (gtk_widget_hide_on_delete),
+                      NULL);
 
-  /* Create the dialog if it doesn't exist already.  */
-  if (!priv->dialog) {
-    parent = gtk_widget_get_toplevel (GTK_WIDGET (button));
-    if (gtk_widget_is_toplevel (parent)) {
-      priv->dialog = hildon_picker_dialog_new (GTK_WINDOW (parent));
+    if (parent) {
+      g_object_set_data_full (G_OBJECT (parent), SHARED_DIALOG_KEY, dialog,
+                              (GDestroyNotify) gtk_widget_destroy);
     } else {
-      priv->dialog = hildon_picker_dialog_new (NULL);
+      unparented_dialog = dialog;
+      g_object_add_weak_pointer (G_OBJECT (dialog), (gpointer *) &unparented_dialog);
     }
+  }
 
-    hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (priv->dialog),
-                                       HILDON_TOUCH_SELECTOR (priv->selector));
-    if (priv->done_button_text) {
-      hildon_picker_dialog_set_done_label (HILDON_PICKER_DIALOG (priv->dialog),
-                                           priv->done_button_text);
-    }
+  return dialog;
+}
+
+static void
+hildon_picker_button_return_dialog (HildonPickerButton *button)
+{
+  HildonPickerButtonPrivate *priv = GET_PRIVATE (button);
+
+  if (priv->dialog == NULL)
+    return;
+
+  g_signal_handlers_disconnect_by_func (priv->dialog,
+                                        hildon_picker_button_on_dialog_response,
+                                        button);
+  g_object_set_data (G_OBJECT (priv->dialog), BORROWER_KEY, NULL);
+  g_object_remove_weak_pointer (G_OBJECT (priv->dialog), (gpointer *) &priv->dialog);
+  priv->dialog = NULL;
+}
 
-    gtk_window_set_modal (GTK_WINDOW (priv->dialog),
-                          gtk_window_get_modal (GTK_WINDOW (parent)));
-    gtk_window_set_title (GTK_WINDOW (priv->dialog),
-                          hildon_button_get_title (HILDON_BUTTON (button)));
-    g_signal_connect (priv->dialog, "response",
+static void
+hildon_picker_button_borrow_dialog (HildonPickerButton *button)
+{
+  HildonPickerButtonPrivate *priv;
+  HildonPickerButton *borrower;
+  GtkWidget *dialog;
+  GtkWidget *parent;
+
+  priv = GET_PRIVATE (button);
+
+  dialog = hildon_picker_button_get_shared_dialog (button);
+
+  borrower = g_object_get_data (G_OBJECT (dialog), BORROWER_KEY);
+  if (borrower != NULL && borrower != button)
+    hildon_picker_button_return_dialog (borrower);
+
+  if (hildon_picker_dialog_get_selector (HILDON_PICKER_DIALOG (dialog)) !=
+      HILDON_TOUCH_SELECTOR (priv->selector)) {
+    hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (dialog),
+                                       HILDON_TOUCH_SELECTOR (priv->selector));
+  }
+  hildon_picker_dialog_set_done_label (HILDON_PICKER_DIALOG (dialog),
+                                       priv->done_button_text ?
+                                       priv->done_button_text : HILDON_STOCK_DONE);
+
+  parent = GTK_WIDGET (gtk_window_get_transient_for (GTK_WINDOW (dialog)));
+  gtk_window_set_modal (GTK_WINDOW (dialog),
+                        parent && gtk_window_get_modal (GTK_WINDOW (parent)));
+  gtk_window_set_title (GTK_WINDOW (dialog),
+                        hildon_button_get_title (HILDON_BUTTON (button)));
+
+  if (priv->dialog == NULL) {
+    priv->dialog = dialog;
+    g_object_add_weak_pointer (G_OBJECT (dialog), (gpointer *) &priv->dialog);
+    g_object_set_data (G_OBJECT (dialog), BORROWER_KEY, button);
+    g_signal_connect (dialog, "response",
                       G_CALLBACK (hildon_picker_button_on_dialog_response),
                       button);
-    g_signal_connect (priv->dialog, "delete-event",
-                      G_CALLBACK (gtk_widget_hide_on_delete),
-                      NULL);
   }
+}
+
+static void
+hildon_picker_button_clicked (GtkButton * button)
+{
+  HildonPickerButtonPrivate *priv;
+
+  priv = GET_PRIVATE (HILDON_PICKER_BUTTON (button));
+
+  hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+  g_return_if_fail (HILDON_IS_TOUCH_SELECTOR (priv->selector));
+
+  hildon_picker_button_borrow_dialog (HILDON_PICKER_BUTTON (button));
 
   if (_current_selector_empty (HILDON_PICKER_BUTTON (button))) {
     g_warning ("There are no elements in the selector. Nothing to show.");
@@ -313,10 +416,98 @@ hildon_picker_button_selector_columns_changed (HildonTouchSelector * selector,
   _selection_changed (HILDON_PICKER_BUTTON (user_data));
 }
 
+static void
+hildon_picker_button_prewarm_release (gpointer  data,
+                                      GObject  *dialog)
+{
+  prewarm_budget++;
+}
+
+static gboolean
+hildon_picker_button_prewarm_idle (gpointer data)
+{
+  HildonPickerButton *button;
+  HildonPickerButtonPrivate *priv;
+  GtkRequisition requisition;
+  GtkWidget *dialog;
+
+  /* One dialog per iteration, to keep the main loop responsive */
+  button = g_queue_pop_head (&prewarm_queue);
+  if (button != NULL) {
+    priv = GET_PRIVATE (button);
+    priv->prewarm_queued = FALSE;
+
+    if (priv->prewarm && priv->dialog == NULL && prewarm_budget > 0 &&
+        gtk_widget_get_mapped (GTK_WIDGET (button)) &&
+        hildon_picker_button_get_selector (button) != NULL) {
+      dialog = hildon_picker_button_get_shared_dialog (button);
+
+      /* The other buttons of the toplevel find it ready */
+      if (!gtk_widget_get_realized (dialog)) {
+        if (hildon_picker_dialog_get_selector (HILDON_PICKER_DIALOG (dialog)) == NULL)
+          hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (dialog),
+                                             HILDON_TOUCH_SELECTOR (priv->selector));
+        gtk_widget_realize (dialog);
+        gtk_widget_get_preferred_size (dialog, NULL, &requisition);
+
+        prewarm_budget--;
+        g_object_weak_ref (G_OBJECT (dialog), hildon_picker_button_prewarm_release, NULL);
+      }
+
+      /* Size the selector of every button in the dialog, unless
+         another button is using it */
+      if (g_object_get_data (G_OBJECT (dialog), BORROWER_KEY) == NULL &&
+          !gtk_widget_get_visible (dialog) &&
+          hildon_picker_dialog_get_selector (HILDON_PICKER_DIALOG (dialog)) !=
+          HILDON_TOUCH_SELECTOR (priv->selector)) {
+        hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (dialog),
+                                           HILDON_TOUCH_SELECTOR (priv->selector));
+        gtk_widget_get_preferred_size (dialog, NULL, &requisition);
+      }
+    }
+  }
+
+  if (g_queue_is_empty (&prewarm_queue) || prewarm_budget == 0) {
+    while ((button = g_queue_pop_head (&prewarm_queue)) != NULL)
+      GET_PRIVATE (button)->prewarm_queued = FALSE;
+    prewarm_idle_id = 0;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+hildon_picker_button_queue_prewarm (HildonPickerButton *button)
+{
+  HildonPickerButtonPrivate *priv = GET_PRIVATE (button);
+
+  if (!priv->prewarm || priv->prewarm_queued || priv->dialog != NULL ||
+      prewarm_budget == 0)
+    return;
+
+  g_queue_push_tail (&prewarm_queue, button);
+  priv->prewarm_queued = TRUE;
+
+  if (prewarm_idle_id == 0)
+    prewarm_idle_id = gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                                 hildon_picker_button_prewarm_idle,
+                                                 NULL, NULL);
+}
+
+static void
+hildon_picker_button_map (GtkWidget *widget)
+{
+  GTK_WIDGET_CLASS (hildon_picker_button_parent_class)->map (widget);
+
+  hildon_picker_button_queue_prewarm (HILDON_PICKER_BUTTON (widget));
+}
+
 static void
 hildon_picker_button_class_init (HildonPickerButtonClass * klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
   GtkButtonClass *button_class = GTK_BUTTON_CLASS (klass);
 
   g_type_class_add_private (klass, sizeof (HildonPickerButtonPrivate));
@@ -325,6 +516,8 @@ hildon_picker_button_class_init (HildonPickerButtonClass * klass)
   object_class->set_property = hildon_picker_button_set_property;
   object_class->finalize = hildon_picker_button_finalize;
 
+  widget_class->map = hildon_picker_button_map;
+
   button_class->clicked = hildon_picker_button_clicked;
 
   g_object_class_install_property (object_class,
@@ -342,6 +535,22 @@ hildon_picker_button_class_init (HildonPickerButtonClass * klass)
                                                         NULL,
                                                         G_PARAM_READWRITE));
 
+  /**
+   * HildonPickerButton:prewarm:
+   *
+   * Whether to prepare the #HildonPickerDialog in an idle after the
+   * button is mapped, instead of when the button is first clicked.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_PREWARM,
+                                   g_param_spec_boolean ("prewarm",
+                                                         "Prewarm",
+                                                         "Whether to prepare the dialog before the button is clicked",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE));
+
   /**
    * HildonPickerButton::value-changed:
    * @widget: the widget that received the signal
@@ -371,6 +580,9 @@ hildon_picker_button_init (HildonPickerButton * self)
   priv->selector = NULL;
   priv->done_button_text = NULL;
   priv->disable_value_changed = FALSE;
+  priv->selector_func = NULL;
+  priv->prewarm = FALSE;
+  priv->prewarm_queued = FALSE;
 
   hildon_button_set_style (HILDON_BUTTON (self),
                            HILDON_BUTTON_STYLE_PICKER);
@@ -453,6 +665,8 @@ hildon_picker_button_set_selector (HildonPickerButton * button,
 
   priv = GET_PRIVATE (button);
 
+  priv->selector_func = NULL;
+
   if (priv->selector == (GtkWidget*) selector) {
       return;
   }
@@ -481,6 +695,10 @@ hildon_picker_button_set_selector (HildonPickerButton * button,
                       button);
 
     value = hildon_touch_selector_get_current_text (HILDON_TOUCH_SELECTOR (priv->selector));
+
+    /* The dialog may have been prepared ahead of time */
+    if (priv->dialog)
+      hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (priv->dialog), selector);
   }
 
   if (!value)
@@ -515,9 +733,40 @@ hildon_picker_button_get_selector (HildonPickerButton * button)
 
   priv = GET_PRIVATE (button);
 
+  if (priv->selector == NULL && priv->selector_func != NULL) {
+    HildonPickerButtonSelectorFunc func = priv->selector_func;
+    gboolean disable_value_changed = priv->disable_value_changed;
+
+    /* The value shown by the button doesn't change */
+    priv->disable_value_changed = TRUE;
+    hildon_picker_button_set_selector (button, func (button));
+    priv->disable_value_changed = disable_value_changed;
+  }
+
   return HILDON_TOUCH_SELECTOR (priv->selector);
 }
 
+G_GNUC_INTERNAL HildonTouchSelector *
+hildon_picker_button_peek_selector              (HildonPickerButton *button)
+{
+  g_return_val_if_fail (HILDON_IS_PICKER_BUTTON (button), NULL);
+
+  return HILDON_TOUCH_SELECTOR (GET_PRIVATE (button)->selector);
+}
+
+G_GNUC_INTERNAL void
+hildon_picker_button_set_selector_func          (HildonPickerButton             *button,
+                                                 HildonPickerButtonSelectorFunc  func)
+{
+  HildonPickerButtonPrivate *priv;
+
+  g_return_if_fail (HILDON_IS_PICKER_BUTTON (button));
+  priv = GET_PRIVATE (button);
+  g_return_if_fail (priv->selector == NULL);
+
+  priv->selector_func = func;
+}
+
 /**
  * hildon_picker_button_get_active:
  * @button: a #HildonPickerButton
@@ -676,3 +925,61 @@ hildon_picker_button_set_done_button_text (HildonPickerButton *button,
                                          priv->done_button_text);
   }
 }
+
+/**
+ * hildon_picker_button_set_prewarm:
+ * @button: a #HildonPickerButton
+ * @prewarm: whether to prepare the dialog of @button ahead of time
+ *
+ * Sets whether the #HildonPickerDialog of @button is built, realized
+ * and sized in a low priority idle once @button is mapped, so the
+ * first click only has to present it. This also builds the selector.
+ *
+ * The buttons of a window share their dialog, the selector of each
+ * of them is packed and sized in it while no button is using it.
+ *
+ * Only a few dialogs are prepared in the whole process, as each one
+ * holds a toplevel window. The rest are built when clicked.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_picker_button_set_prewarm                (HildonPickerButton *button,
+                                                 gboolean            prewarm)
+{
+  HildonPickerButtonPrivate *priv;
+
+  g_return_if_fail (HILDON_IS_PICKER_BUTTON (button));
+
+  priv = GET_PRIVATE (button);
+
+  prewarm = prewarm ? TRUE : FALSE;
+  if (priv->prewarm == prewarm)
+    return;
+
+  priv->prewarm = prewarm;
+
+  if (prewarm && gtk_widget_get_mapped (GTK_WIDGET (button)))
+    hildon_picker_button_queue_prewarm (button);
+
+  g_object_notify (G_OBJECT (button), "prewarm");
+}
+
+/**
+ * hildon_picker_button_get_prewarm:
+ * @button: a #HildonPickerButton
+ *
+ * Gets whether the dialog of @button is prepared ahead of time. See
+ * hildon_picker_button_set_prewarm().
+ *
+ * Returns: %TRUE if the dialog is prepared ahead of time
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_picker_button_get_prewarm                (HildonPickerButton *button)
+{
+  g_return_val_if_fail (HILDON_IS_PICKER_BUTTON (button), FALSE);
+
+  return GET_PRIVATE (button)->prewarm;
+}
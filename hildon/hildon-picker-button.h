@@ -97,6 +97,13 @@ hildon_picker_button_set_done_button_text       (HildonPickerButton *button,
 void
 hildon_picker_button_value_changed              (HildonPickerButton *button);
 
+void
+hildon_picker_button_set_prewarm                (HildonPickerButton *button,
+                                                 gboolean            prewarm);
+
+gboolean
+hildon_picker_button_get_prewarm                (HildonPickerButton *button);
+
 G_END_DECLS
 
 #endif /* __HILDON_PICKER_BUTTON__ */
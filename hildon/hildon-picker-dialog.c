@@ -49,6 +49,7 @@
 #include <libintl.h>
 
 #include "hildon-touch-selector.h"
+#include "hildon-touch-selector-private.h"
 #include "hildon-touch-selector-entry.h"
 #include "hildon-picker-dialog.h"
 #include "hildon-stock.h"
@@ -66,7 +67,7 @@ struct _HildonPickerDialogPrivate
   gulong signal_columns_changed_id;
 
   gboolean center_on_show;
-  GSList *current_selection;
+  HildonTouchSelectorSnapshot *current_selection;
   gchar *current_text;
 };
 
@@ -568,19 +569,11 @@ hildon_picker_dialog_get_done_label (HildonPickerDialog * dialog)
   return gtk_button_get_label (GTK_BUTTON (priv->button));
 }
 
-static void
-free_path_list (GList *list)
-{
-  g_list_foreach (list, (GFunc) gtk_tree_path_free, NULL);
-  g_list_free (list);
-}
-
 static void
 _clean_current_selection (HildonPickerDialog *dialog)
 {
   if (dialog->priv->current_selection) {
-    g_slist_foreach (dialog->priv->current_selection, (GFunc) free_path_list, NULL);
-    g_slist_free (dialog->priv->current_selection);
+    hildon_touch_selector_snapshot_free (dialog->priv->current_selection);
     dialog->priv->current_selection = NULL;
   }
   if (dialog->priv->current_text) {
@@ -593,18 +586,12 @@ static void
 _save_current_selection (HildonPickerDialog *dialog)
 {
   HildonTouchSelector *selector;
-  gint i, columns;
 
   selector = HILDON_TOUCH_SELECTOR (dialog->priv->selector);
 
   _clean_current_selection (dialog);
 
-  columns = hildon_touch_selector_get_num_columns (selector);
-  for (i = 0; i  < columns; i++) {
-    dialog->priv->current_selection
-      = g_slist_append (dialog->priv->current_selection,
-                        hildon_touch_selector_get_selected_rows (selector, i));
-  }
+  dialog->priv->current_selection = hildon_touch_selector_snapshot_new (selector);
   if (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector)) {
 	  HildonEntry *entry = hildon_touch_selector_entry_get_entry (HILDON_TOUCH_SELECTOR_ENTRY (selector));
 	  dialog->priv->current_text = g_strdup (gtk_entry_get_text (GTK_ENTRY (entry)));
@@ -614,43 +601,21 @@ _save_current_selection (HildonPickerDialog *dialog)
 static void
 _restore_current_selection (HildonPickerDialog *dialog)
 {
-  GSList *current_selection, *iter;
-  GList *selected, *selected_iter;
-  GtkTreePath *current_path;
   HildonTouchSelector *selector;
-  GtkTreeModel *model;
-  GtkTreeIter tree_iter;
-  gint i;
 
   if (dialog->priv->current_selection == NULL)
     return;
 
-  current_selection = dialog->priv->current_selection;
   selector = HILDON_TOUCH_SELECTOR (dialog->priv->selector);
 
-  if (hildon_touch_selector_get_num_columns (selector) !=
-      g_slist_length (current_selection)) {
-    /* We conclude that if the current selection has the same
-       numbers of columns that the selector, all this ok
-       Anyway this shouldn't happen. */
+  if (dialog->priv->signal_changed_id)
+    g_signal_handler_block (selector, dialog->priv->signal_changed_id);
+  if (!hildon_touch_selector_snapshot_restore (selector, dialog->priv->current_selection)) {
+    /* The snapshot has one entry per column of the selector, this
+       shouldn't happen. */
     g_critical ("Trying to restore the selection on a selector after change"
                 " the number of columns. Are you removing columns while the"
                 " dialog is open?");
-    return;
-  }
-
-  if (dialog->priv->signal_changed_id)
-    g_signal_handler_block (selector, dialog->priv->signal_changed_id);
-  for (iter = current_selection, i = 0; iter; iter = g_slist_next (iter), i++) {
-    selected = (GList *) (iter->data);
-    model = hildon_touch_selector_get_model (selector, i);
-    if (selected)
-        hildon_touch_selector_unselect_all (selector, i);
-    for (selected_iter = selected; selected_iter; selected_iter = g_list_next (selected_iter)) {
-      current_path = (GtkTreePath *) selected_iter->data;
-      if (gtk_tree_model_get_iter (model, &tree_iter, current_path))
-          hildon_touch_selector_select_iter (selector, i, &tree_iter, FALSE);
-    }
   }
   if (HILDON_IS_TOUCH_SELECTOR_ENTRY (selector) && dialog->priv->current_text != NULL) {
     HildonEntry *entry = hildon_touch_selector_entry_get_entry (HILDON_TOUCH_SELECTOR_ENTRY (selector));
@@ -683,6 +648,7 @@ setup_interaction_mode (HildonPickerDialog * dialog)
   if (dialog->priv->signal_changed_id) {
     g_signal_handler_disconnect (dialog->priv->selector,
                                  dialog->priv->signal_changed_id);
+    dialog->priv->signal_changed_id = 0;
   }
 
   if (requires_done_button (dialog) == FALSE) {
@@ -733,6 +699,12 @@ _hildon_picker_dialog_set_selector (HildonPickerDialog * dialog,
             g_signal_handler_disconnect (dialog->priv->selector,
                                          dialog->priv->signal_columns_changed_id);
     }
+    /* The old selector must not close the dialog anymore */
+    if (dialog->priv->signal_changed_id) {
+      g_signal_handler_disconnect (dialog->priv->selector,
+                                   dialog->priv->signal_changed_id);
+      dialog->priv->signal_changed_id = 0;
+    }
   }
 
   dialog->priv->selector = GTK_WIDGET (selector);
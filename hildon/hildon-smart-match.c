@@ -0,0 +1,912 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * SECTION:hildon-smart-match
+ * @short_description: Indexed smart matching of the rows of a #GtkTreeModel.
+ *
+ * A #HildonSmartMatchIndex answers the same question as calling
+ * hildon_helper_smart_match() with every space-separated token of a
+ * search text on the normalized text of each row of a model, but
+ * without looking at every row.
+ *
+ * The index is built once from a %G_TYPE_STRING column of a model. It
+ * keeps the normalized text of each row together with a sorted list
+ * of the positions where words start. The rows matching a token are
+ * then found with a binary search, and the rows matching several
+ * tokens by intersecting their sorted row lists.
+ *
+ * The index is a snapshot: it is not updated when the model changes,
+ * so it must be freed and built again after that. Only the toplevel
+ * rows of the model are indexed.
+ *
+ * When the rows are not indexed, a #HildonSmartMatcher compiles the
+ * search text once, so that each row is matched against all the
+ * tokens in a single pass over its text.
+ *
+ * #HildonNormalizedStrings normalizes many strings at once, such as
+ * the rows of a model, into a single block of memory. The index keeps
+ * the text of its rows this way.
+ *
+ * <example>
+ * <title>Looking up the rows of a model</title>
+ * <programlisting>
+ * HildonSmartMatchIndex *index;
+ * GArray *rows;
+ * guint i;
+ * <!-- -->
+ * index = hildon_smart_match_index_new (model, TEXT_COLUMN);
+ * rows = hildon_smart_match_index_lookup (index, "joh smi");
+ * <!-- -->
+ * for (i = 0; i < rows->len; i++)
+ *     g_print ("%u\n", g_array_index (rows, guint, i));
+ * <!-- -->
+ * g_array_free (rows, TRUE);
+ * hildon_smart_match_index_free (index);
+ * </programlisting>
+ * </example>
+ */
+
+#ifdef                                          HAVE_CONFIG_H
+#include                                        <config.h>
+#endif
+
+#include                                        <stdlib.h>
+#include                                        <string.h>
+
+#include                                        "hildon-smart-match.h"
+#include                                        "hildon-helper.h"
+
+typedef struct
+{
+    const gchar *start;
+    guint row;
+} HildonSmartMatchWord;
+
+/* Marks the strings that could not be normalized */
+#define                                         INVALID_OFFSET G_MAXUINT
+
+struct                                          _HildonNormalizedStrings
+{
+    guint n_strings;
+    guint *offsets;
+
+    gchar *arena;
+    gsize arena_size;
+    gsize arena_used;
+};
+
+struct                                          _HildonSmartMatchIndex
+{
+    guint n_rows;
+    HildonNormalizedStrings *rows;
+
+    guint n_words;
+    HildonSmartMatchWord *words;
+};
+
+typedef struct
+{
+    gchar *text;                                /* normalized, lowercase */
+    gsize length;
+    gsize *skip;                                /* Horspool shifts, for tokens matched anywhere */
+} HildonSmartMatchToken;
+
+/* Word tokens past this number are matched one by one */
+#define                                         MAX_MASKED_TOKENS 64
+
+struct                                          _HildonSmartMatcher
+{
+    guint n_tokens;
+
+    guint n_word_tokens;
+    HildonSmartMatchToken *word_tokens;
+
+    guint n_other_tokens;
+    HildonSmartMatchToken *other_tokens;
+
+    /* For each lowercase character, the word tokens starting with it */
+    guint64 first_char_tokens[256];
+};
+
+static gboolean
+matcher_match_other_tokens                      (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string);
+
+static gint
+compare_words                                   (gconstpointer a,
+                                                 gconstpointer b)
+{
+    const HildonSmartMatchWord *wa = a;
+    const HildonSmartMatchWord *wb = b;
+    gint ret = strcmp (wa->start, wb->start);
+
+    if (ret == 0)
+        ret = (wa->row > wb->row) - (wa->row < wb->row);
+
+    return ret;
+}
+
+static gint
+compare_rows                                    (gconstpointer a,
+                                                 gconstpointer b)
+{
+    guint ra = *(const guint *) a;
+    guint rb = *(const guint *) b;
+
+    return (ra > rb) - (ra < rb);
+}
+
+/* Same notion of word start as hildon_helper_smart_match() */
+static gboolean
+is_word_start                                   (const gchar *string,
+                                                 const gchar *p)
+{
+    return g_ascii_isalnum (*p) &&
+        (p == string || !g_ascii_isalnum (*(p - 1)));
+}
+
+static HildonNormalizedStrings *
+normalized_strings_new                          (guint n_strings)
+{
+    HildonNormalizedStrings *strings = g_slice_new0 (HildonNormalizedStrings);
+
+    strings->offsets = g_new (guint, n_strings);
+
+    /* A guess for short strings such as names, it grows as needed */
+    strings->arena_size = MAX (n_strings * 16, 64);
+    strings->arena = g_malloc (strings->arena_size);
+
+    return strings;
+}
+
+/**
+ * normalized_strings_append:
+ *
+ * Normalizes @string right at the end of the arena, growing it only
+ * when the result does not fit.
+ **/
+static void
+normalized_strings_append                       (HildonNormalizedStrings *strings,
+                                                 const gchar             *string)
+{
+    gsize room = strings->arena_size - strings->arena_used;
+    gssize len = -1;
+
+    if (string != NULL)
+        len = hildon_helper_normalize_string_to_buffer (string,
+                                                        strings->arena + strings->arena_used,
+                                                        room);
+
+    if (len < 0) {
+        strings->offsets[strings->n_strings++] = INVALID_OFFSET;
+        return;
+    }
+
+    if ((gsize) len >= room) {
+        strings->arena_size = MAX (strings->arena_size * 2,
+                                   strings->arena_used + len + 1);
+        strings->arena = g_realloc (strings->arena, strings->arena_size);
+        hildon_helper_normalize_string_to_buffer (string,
+                                                  strings->arena + strings->arena_used,
+                                                  len + 1);
+    }
+
+    strings->offsets[strings->n_strings++] = strings->arena_used;
+    strings->arena_used += len + 1;
+}
+
+/* Gives back the unused end of the arena */
+static HildonNormalizedStrings *
+normalized_strings_finish                       (HildonNormalizedStrings *strings)
+{
+    strings->arena = g_realloc (strings->arena, strings->arena_used);
+    strings->arena_size = strings->arena_used;
+
+    return strings;
+}
+
+/**
+ * hildon_normalized_strings_new:
+ * @strings: a %NULL-terminated array of strings
+ *
+ * Normalizes all the strings in @strings, as
+ * hildon_helper_normalize_string() does, and stores the results one
+ * after the other in a single block of memory.
+ *
+ * Plain ASCII strings are copied as they are, and no memory is
+ * allocated for each string. This makes building search keys for a
+ * long list much cheaper than calling hildon_helper_normalize_string()
+ * on each string.
+ *
+ * Returns: a new #HildonNormalizedStrings. Free it with
+ * hildon_normalized_strings_free().
+ *
+ * Since: 3.0
+ **/
+HildonNormalizedStrings *
+hildon_normalized_strings_new                   (const gchar * const *strings)
+{
+    HildonNormalizedStrings *normalized;
+    guint n, i;
+
+    g_return_val_if_fail (strings != NULL, NULL);
+
+    n = g_strv_length ((gchar **) strings);
+    normalized = normalized_strings_new (n);
+
+    for (i = 0; i < n; i++)
+        normalized_strings_append (normalized, strings[i]);
+
+    return normalized_strings_finish (normalized);
+}
+
+/**
+ * hildon_normalized_strings_new_from_model:
+ * @model: a #GtkTreeModel
+ * @column: a %G_TYPE_STRING column in @model
+ *
+ * Like hildon_normalized_strings_new(), for the text in @column of the
+ * toplevel rows of @model. The string at index i is the text of the
+ * row at path i.
+ *
+ * Returns: a new #HildonNormalizedStrings. Free it with
+ * hildon_normalized_strings_free().
+ *
+ * Since: 3.0
+ **/
+HildonNormalizedStrings *
+hildon_normalized_strings_new_from_model        (GtkTreeModel *model,
+                                                 gint          column)
+{
+    HildonNormalizedStrings *normalized;
+    GtkTreeIter iter;
+    guint n;
+
+    g_return_val_if_fail (GTK_IS_TREE_MODEL (model), NULL);
+    g_return_val_if_fail (column >= 0 &&
+                          column < gtk_tree_model_get_n_columns (model), NULL);
+
+    n = gtk_tree_model_iter_n_children (model, NULL);
+    normalized = normalized_strings_new (n);
+
+    if (gtk_tree_model_get_iter_first (model, &iter)) {
+        do {
+            gchar *string;
+
+            gtk_tree_model_get (model, &iter, column, &string, -1);
+            normalized_strings_append (normalized, string);
+            g_free (string);
+        } while (normalized->n_strings < n && gtk_tree_model_iter_next (model, &iter));
+    }
+
+    while (normalized->n_strings < n)
+        normalized_strings_append (normalized, NULL);
+
+    return normalized_strings_finish (normalized);
+}
+
+/**
+ * hildon_normalized_strings_free:
+ * @strings: a #HildonNormalizedStrings
+ *
+ * Frees @strings and all the normalized strings at once.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_normalized_strings_free                  (HildonNormalizedStrings *strings)
+{
+    if (strings == NULL)
+        return;
+
+    g_free (strings->arena);
+    g_free (strings->offsets);
+    g_slice_free (HildonNormalizedStrings, strings);
+}
+
+/**
+ * hildon_normalized_strings_get_length:
+ * @strings: a #HildonNormalizedStrings
+ *
+ * Returns: the number of strings in @strings
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_normalized_strings_get_length            (HildonNormalizedStrings *strings)
+{
+    g_return_val_if_fail (strings != NULL, 0);
+
+    return strings->n_strings;
+}
+
+/**
+ * hildon_normalized_strings_get:
+ * @strings: a #HildonNormalizedStrings
+ * @i: the index of a string
+ *
+ * Returns: the normalized version of the string at @i, or %NULL if it
+ * was %NULL or could not be normalized. This string is owned by
+ * @strings and must not be freed or modified.
+ *
+ * Since: 3.0
+ **/
+const gchar *
+hildon_normalized_strings_get                   (HildonNormalizedStrings *strings,
+                                                 guint                    i)
+{
+    g_return_val_if_fail (strings != NULL, NULL);
+    g_return_val_if_fail (i < strings->n_strings, NULL);
+
+    if (strings->offsets[i] == INVALID_OFFSET)
+        return NULL;
+
+    return strings->arena + strings->offsets[i];
+}
+
+/**
+ * hildon_smart_match_index_new:
+ * @model: a #GtkTreeModel
+ * @text_column: a %G_TYPE_STRING column in @model
+ *
+ * Builds an index of the text in @text_column of the toplevel rows of
+ * @model. The text of every row is normalized with
+ * hildon_helper_normalize_string() and converted to lowercase.
+ *
+ * Returns: a new #HildonSmartMatchIndex. Free it with
+ * hildon_smart_match_index_free().
+ *
+ * Since: 3.0
+ **/
+HildonSmartMatchIndex *
+hildon_smart_match_index_new                    (GtkTreeModel *model,
+                                                 gint          text_column)
+{
+    HildonSmartMatchIndex *index;
+    guint i, n_words;
+
+    g_return_val_if_fail (GTK_IS_TREE_MODEL (model), NULL);
+    g_return_val_if_fail (text_column >= 0 &&
+                          text_column < gtk_tree_model_get_n_columns (model), NULL);
+
+    index = g_slice_new0 (HildonSmartMatchIndex);
+    index->rows = hildon_normalized_strings_new_from_model (model, text_column);
+    index->n_rows = hildon_normalized_strings_get_length (index->rows);
+
+    /* The arena is ours, lowercase it in place */
+    for (i = 0; i < index->rows->arena_used; i++)
+        index->rows->arena[i] = g_ascii_tolower (index->rows->arena[i]);
+
+    n_words = 0;
+    for (i = 0; i < index->n_rows; i++) {
+        const gchar *row = hildon_normalized_strings_get (index->rows, i);
+        const gchar *p;
+
+        for (p = row; p != NULL && *p != '\0'; p++) {
+            if (is_word_start (row, p))
+                n_words++;
+        }
+    }
+
+    index->words = g_new (HildonSmartMatchWord, n_words);
+    for (i = 0; i < index->n_rows; i++) {
+        const gchar *row = hildon_normalized_strings_get (index->rows, i);
+        const gchar *p;
+
+        for (p = row; p != NULL && *p != '\0'; p++) {
+            if (is_word_start (row, p)) {
+                index->words[index->n_words].start = p;
+                index->words[index->n_words].row = i;
+                index->n_words++;
+            }
+        }
+    }
+
+    qsort (index->words, index->n_words, sizeof (HildonSmartMatchWord),
+           compare_words);
+
+    return index;
+}
+
+/**
+ * hildon_smart_match_index_free:
+ * @index: a #HildonSmartMatchIndex
+ *
+ * Frees @index and all the memory it uses.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_smart_match_index_free                   (HildonSmartMatchIndex *index)
+{
+    if (index == NULL)
+        return;
+
+    g_free (index->words);
+    hildon_normalized_strings_free (index->rows);
+    g_slice_free (HildonSmartMatchIndex, index);
+}
+
+/**
+ * hildon_smart_match_index_get_n_rows:
+ * @index: a #HildonSmartMatchIndex
+ *
+ * Returns: the number of rows in @index
+ *
+ * Since: 3.0
+ **/
+guint
+hildon_smart_match_index_get_n_rows             (HildonSmartMatchIndex *index)
+{
+    g_return_val_if_fail (index != NULL, 0);
+
+    return index->n_rows;
+}
+
+/**
+ * hildon_smart_match_index_get_row_text:
+ * @index: a #HildonSmartMatchIndex
+ * @row: a row of @index
+ *
+ * Returns: the normalized, lowercase text of @row, or %NULL if it
+ * could not be normalized. This string is owned by @index and must
+ * not be freed or modified.
+ *
+ * Since: 3.0
+ **/
+const gchar *
+hildon_smart_match_index_get_row_text           (HildonSmartMatchIndex *index,
+                                                 guint                  row)
+{
+    g_return_val_if_fail (index != NULL, NULL);
+    g_return_val_if_fail (row < index->n_rows, NULL);
+
+    return hildon_normalized_strings_get (index->rows, row);
+}
+
+/**
+ * lookup_token:
+ * @index: a #HildonSmartMatchIndex
+ * @token: a normalized, lowercase token starting with an alphanumeric
+ *
+ * Returns: a sorted array of the rows with a word starting with @token
+ **/
+static GArray *
+lookup_token                                    (HildonSmartMatchIndex *index,
+                                                 const gchar           *token)
+{
+    GArray *rows;
+    gsize len = strlen (token);
+    guint lo = 0, hi = index->n_words, first, i, last;
+
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (strcmp (index->words[mid].start, token) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    first = lo;
+
+    hi = index->n_words;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (strncmp (index->words[mid].start, token, len) == 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    rows = g_array_sized_new (FALSE, FALSE, sizeof (guint), lo - first);
+    for (i = first; i < lo; i++)
+        g_array_append_val (rows, index->words[i].row);
+
+    g_array_sort (rows, compare_rows);
+
+    /* A row may have several words starting with @token */
+    last = 0;
+    for (i = 0; i < rows->len; i++) {
+        if (last == 0 ||
+            g_array_index (rows, guint, i) != g_array_index (rows, guint, last - 1))
+            g_array_index (rows, guint, last++) = g_array_index (rows, guint, i);
+    }
+    g_array_set_size (rows, last);
+
+    return rows;
+}
+
+static void
+intersect_rows                                  (GArray *rows,
+                                                 GArray *other)
+{
+    guint i = 0, j = 0, last = 0;
+
+    while (i < rows->len && j < other->len) {
+        guint a = g_array_index (rows, guint, i);
+        guint b = g_array_index (other, guint, j);
+
+        if (a < b) {
+            i++;
+        } else if (a > b) {
+            j++;
+        } else {
+            g_array_index (rows, guint, last++) = a;
+            i++;
+            j++;
+        }
+    }
+
+    g_array_set_size (rows, last);
+}
+
+/**
+ * hildon_smart_match_index_lookup:
+ * @index: a #HildonSmartMatchIndex
+ * @text: the text to search for
+ *
+ * Finds the rows of @index matching all the space-separated tokens of
+ * @text. A row matches a token if hildon_helper_smart_match() finds
+ * the normalized token in the normalized text of the row.
+ *
+ * Tokens starting with an alphanumeric character are looked up in the
+ * index. Other tokens can match anywhere in the text, so they are
+ * checked on the rows matching the rest of the tokens.
+ *
+ * Returns: a newly allocated, sorted #GArray of the matching rows as
+ * #guint. Free it with g_array_free().
+ *
+ * Since: 3.0
+ **/
+GArray *
+hildon_smart_match_index_lookup                 (HildonSmartMatchIndex *index,
+                                                 const gchar           *text)
+{
+    HildonSmartMatcher *matcher;
+    GArray *rows = NULL;
+    guint i;
+
+    g_return_val_if_fail (index != NULL, NULL);
+    g_return_val_if_fail (text != NULL, NULL);
+
+    matcher = hildon_smart_matcher_new (text);
+
+    for (i = 0; i < matcher->n_word_tokens; i++) {
+        GArray *token_rows = lookup_token (index, matcher->word_tokens[i].text);
+
+        if (rows == NULL) {
+            rows = token_rows;
+        } else {
+            intersect_rows (rows, token_rows);
+            g_array_free (token_rows, TRUE);
+        }
+    }
+
+    if (rows == NULL) {
+        guint row;
+
+        rows = g_array_sized_new (FALSE, FALSE, sizeof (guint), index->n_rows);
+        for (row = 0; row < index->n_rows; row++)
+            g_array_append_val (rows, row);
+    }
+
+    if (matcher->n_tokens > matcher->n_word_tokens) {
+        guint j, last = 0;
+
+        for (j = 0; j < rows->len; j++) {
+            guint row = g_array_index (rows, guint, j);
+
+            if (matcher_match_other_tokens (matcher,
+                                            hildon_normalized_strings_get (index->rows, row)))
+                g_array_index (rows, guint, last++) = row;
+        }
+        g_array_set_size (rows, last);
+    }
+
+    hildon_smart_matcher_free (matcher);
+
+    return rows;
+}
+
+/**
+ * hildon_smart_matcher_new:
+ * @text: the text to search for
+ *
+ * Compiles @text for matching many strings with
+ * hildon_smart_matcher_match().
+ *
+ * @text is split in space-separated tokens, and each one is normalized
+ * with hildon_helper_normalize_string() once. A string then matches if
+ * hildon_helper_smart_match() finds every token in it.
+ *
+ * Returns: a new #HildonSmartMatcher. Free it with
+ * hildon_smart_matcher_free().
+ *
+ * Since: 3.0
+ **/
+HildonSmartMatcher *
+hildon_smart_matcher_new                        (const gchar *text)
+{
+    HildonSmartMatcher *matcher;
+    gchar **tokens;
+    guint n, i;
+
+    g_return_val_if_fail (text != NULL, NULL);
+
+    tokens = g_strsplit (text, " ", -1);
+    n = g_strv_length (tokens);
+
+    matcher = g_slice_new0 (HildonSmartMatcher);
+    matcher->word_tokens = g_new0 (HildonSmartMatchToken, n);
+    matcher->other_tokens = g_new0 (HildonSmartMatchToken, n);
+
+    for (i = 0; i < n; i++) {
+        HildonSmartMatchToken *token;
+        gchar *normalized;
+
+        normalized = hildon_helper_normalize_string (tokens[i]);
+        if (normalized == NULL)
+            continue;
+
+        matcher->n_tokens++;
+
+        /* An empty token only requires a non-empty string */
+        if (normalized[0] == '\0') {
+            g_free (normalized);
+            continue;
+        }
+
+        if (g_ascii_isalnum (normalized[0])) {
+            guint t = matcher->n_word_tokens++;
+
+            token = &matcher->word_tokens[t];
+            if (t < MAX_MASKED_TOKENS)
+                matcher->first_char_tokens[(guchar) g_ascii_tolower (normalized[0])] |=
+                    G_GUINT64_CONSTANT (1) << t;
+        } else {
+            gsize len = strlen (normalized);
+            gsize j;
+
+            token = &matcher->other_tokens[matcher->n_other_tokens++];
+            token->skip = g_new (gsize, 256);
+            for (j = 0; j < 256; j++)
+                token->skip[j] = len;
+            for (j = 0; j + 1 < len; j++)
+                token->skip[(guchar) g_ascii_tolower (normalized[j])] = len - 1 - j;
+        }
+
+        token->text = g_ascii_strdown (normalized, -1);
+        token->length = strlen (token->text);
+        g_free (normalized);
+    }
+
+    g_strfreev (tokens);
+
+    return matcher;
+}
+
+/**
+ * hildon_smart_matcher_free:
+ * @matcher: a #HildonSmartMatcher
+ *
+ * Frees @matcher and all the memory it uses.
+ *
+ * Since: 3.0
+ **/
+void
+hildon_smart_matcher_free                       (HildonSmartMatcher *matcher)
+{
+    guint i;
+
+    if (matcher == NULL)
+        return;
+
+    for (i = 0; i < matcher->n_word_tokens; i++)
+        g_free (matcher->word_tokens[i].text);
+
+    for (i = 0; i < matcher->n_other_tokens; i++) {
+        g_free (matcher->other_tokens[i].text);
+        g_free (matcher->other_tokens[i].skip);
+    }
+
+    g_free (matcher->word_tokens);
+    g_free (matcher->other_tokens);
+    g_slice_free (HildonSmartMatcher, matcher);
+}
+
+/**
+ * matcher_match_word_tokens:
+ *
+ * Looks for all the word tokens of @matcher in a single pass over the
+ * word starts of @string, comparing each word start only with the
+ * tokens starting with the same character that did not match yet.
+ *
+ * Returns: whether all the word tokens of @matcher match @string
+ **/
+static gboolean
+matcher_match_word_tokens                       (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string)
+{
+    guint n = MIN (matcher->n_word_tokens, MAX_MASKED_TOKENS);
+    guint64 pending;
+    const gchar *p;
+    guint i;
+
+    for (i = MAX_MASKED_TOKENS; i < matcher->n_word_tokens; i++) {
+        if (hildon_helper_smart_match (string, matcher->word_tokens[i].text) == NULL)
+            return FALSE;
+    }
+
+    pending = n == MAX_MASKED_TOKENS ?
+        G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << n) - 1;
+
+    for (p = string; *p != '\0' && pending != 0;) {
+        guint64 candidates;
+        guint t;
+
+        while (*p != '\0' && !g_ascii_isalnum (*p))
+            p++;
+        if (*p == '\0')
+            break;
+
+        candidates = pending & matcher->first_char_tokens[(guchar) g_ascii_tolower (*p)];
+        for (t = 0; candidates != 0; t++, candidates >>= 1) {
+            const HildonSmartMatchToken *token = &matcher->word_tokens[t];
+
+            if ((candidates & 1) &&
+                g_ascii_strncasecmp (p + 1, token->text + 1, token->length - 1) == 0)
+                pending &= ~(G_GUINT64_CONSTANT (1) << t);
+        }
+
+        while (g_ascii_isalnum (*p))
+            p++;
+    }
+
+    return pending == 0;
+}
+
+/* Case insensitive Horspool search, like strcasestr() */
+static gboolean
+token_match_anywhere                            (const HildonSmartMatchToken *token,
+                                                 const gchar                 *string,
+                                                 gsize                        length)
+{
+    gsize last = token->length - 1;
+    gsize pos = 0;
+
+    while (pos + last < length) {
+        gsize j = last;
+
+        while (g_ascii_tolower (string[pos + j]) == token->text[j]) {
+            if (j == 0)
+                return TRUE;
+            j--;
+        }
+
+        pos += token->skip[(guchar) g_ascii_tolower (string[pos + last])];
+    }
+
+    return FALSE;
+}
+
+static gboolean
+matcher_match_other_tokens                      (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string)
+{
+    gsize length;
+    guint i;
+
+    if (string == NULL || string[0] == '\0')
+        return FALSE;
+
+    length = strlen (string);
+    for (i = 0; i < matcher->n_other_tokens; i++) {
+        if (!token_match_anywhere (&matcher->other_tokens[i], string, length))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * hildon_smart_matcher_match_normalized:
+ * @matcher: a #HildonSmartMatcher
+ * @string: a string already normalized with
+ * hildon_helper_normalize_string(), or %NULL
+ *
+ * Like hildon_smart_matcher_match(), for strings that are already
+ * normalized, such as the rows of a #HildonSmartMatchIndex.
+ *
+ * Returns: whether @string matches all the tokens of @matcher
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_smart_matcher_match_normalized           (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string)
+{
+    g_return_val_if_fail (matcher != NULL, FALSE);
+
+    if (matcher->n_tokens == 0)
+        return TRUE;
+
+    if (!matcher_match_other_tokens (matcher, string))
+        return FALSE;
+
+    return matcher->n_word_tokens == 0 ||
+        matcher_match_word_tokens (matcher, string);
+}
+
+/**
+ * hildon_smart_matcher_match:
+ * @matcher: a #HildonSmartMatcher
+ * @string: a string, or %NULL
+ *
+ * Normalizes @string with hildon_helper_normalize_string_to_buffer(),
+ * without allocating memory unless @string is long, and checks
+ * whether it matches all the tokens of @matcher.
+ *
+ * A matcher without tokens matches any string. Otherwise, %NULL or
+ * empty strings never match.
+ *
+ * @matcher is not modified, so it can be used from several threads
+ * at the same time.
+ *
+ * Returns: whether @string matches all the tokens of @matcher
+ *
+ * Since: 3.0
+ **/
+gboolean
+hildon_smart_matcher_match                      (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string)
+{
+    gchar buffer[256];
+    gchar *normalized = buffer;
+    gboolean ret;
+    gssize len;
+
+    g_return_val_if_fail (matcher != NULL, FALSE);
+
+    if (matcher->n_tokens == 0)
+        return TRUE;
+
+    if (string == NULL)
+        return FALSE;
+
+    len = hildon_helper_normalize_string_to_buffer (string, buffer, sizeof (buffer));
+    if (len < 0)
+        return FALSE;
+
+    if ((gsize) len >= sizeof (buffer)) {
+        normalized = g_malloc (len + 1);
+        hildon_helper_normalize_string_to_buffer (string, normalized, len + 1);
+    }
+
+    ret = hildon_smart_matcher_match_normalized (matcher, normalized);
+
+    if (normalized != buffer)
+        g_free (normalized);
+
+    return ret;
+}
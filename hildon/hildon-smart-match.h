@@ -0,0 +1,87 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2009 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_SMART_MATCH_H__
+#define                                         __HILDON_SMART_MATCH_H__
+
+#include                                        <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct                                  _HildonSmartMatchIndex HildonSmartMatchIndex;
+
+typedef struct                                  _HildonSmartMatcher HildonSmartMatcher;
+
+typedef struct                                  _HildonNormalizedStrings HildonNormalizedStrings;
+
+HildonNormalizedStrings *
+hildon_normalized_strings_new                   (const gchar * const *strings);
+
+HildonNormalizedStrings *
+hildon_normalized_strings_new_from_model        (GtkTreeModel *model,
+                                                 gint          column);
+
+void
+hildon_normalized_strings_free                  (HildonNormalizedStrings *strings);
+
+guint
+hildon_normalized_strings_get_length            (HildonNormalizedStrings *strings);
+
+const gchar *
+hildon_normalized_strings_get                   (HildonNormalizedStrings *strings,
+                                                 guint                    i);
+
+HildonSmartMatchIndex *
+hildon_smart_match_index_new                    (GtkTreeModel *model,
+                                                 gint          text_column);
+
+void
+hildon_smart_match_index_free                   (HildonSmartMatchIndex *index);
+
+guint
+hildon_smart_match_index_get_n_rows             (HildonSmartMatchIndex *index);
+
+const gchar *
+hildon_smart_match_index_get_row_text           (HildonSmartMatchIndex *index,
+                                                 guint                  row);
+
+GArray *
+hildon_smart_match_index_lookup                 (HildonSmartMatchIndex *index,
+                                                 const gchar           *text);
+
+HildonSmartMatcher *
+hildon_smart_matcher_new                        (const gchar *text);
+
+void
+hildon_smart_matcher_free                       (HildonSmartMatcher *matcher);
+
+gboolean
+hildon_smart_matcher_match                      (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string);
+
+gboolean
+hildon_smart_matcher_match_normalized           (const HildonSmartMatcher *matcher,
+                                                 const gchar              *string);
+
+G_END_DECLS
+
+#endif                                          /* __HILDON_SMART_MATCH_H__ */
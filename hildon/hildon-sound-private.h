@@ -0,0 +1,41 @@
+/*
+ * This file is a part of hildon
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#ifndef                                         __HILDON_SOUND_PRIVATE_H__
+#define                                         __HILDON_SOUND_PRIVATE_H__
+
+#include                                        <glib.h>
+
+G_BEGIN_DECLS
+
+#define                                         HILDON_SOUND_CONFIRMATION_NOTE \
+                                                "/usr/share/sounds/ui-confirmation_note.wav"
+
+#define                                         HILDON_SOUND_INFORMATION_NOTE \
+                                                "/usr/share/sounds/ui-information_note.wav"
+
+G_GNUC_INTERNAL void
+hildon_sound_init                               (void);
+
+G_END_DECLS
+
+#endif                                          /* __HILDON_SOUND_PRIVATE_H__ */
@@ -36,47 +36,177 @@
 #include <canberra.h>
 
 #include "hildon-sound.h"
+#include "hildon-sound-private.h"
 
 #define ALARM_GCONF_PATH "/apps/osso/sound/system_alert_volume"
 
-static ca_context *hildon_ca_context_get (void);
+typedef enum
+{
+    CONTEXT_CLOSED,
+    CONTEXT_OPENING,
+    CONTEXT_READY
+} HildonSoundContextState;
+
+/* Time to wait before opening the context again after it failed, in
+ * microseconds. The sound server may not be up yet at startup. */
+#define CONTEXT_RETRY_INTERVAL (5 * G_USEC_PER_SEC)
+
+/* Samples uploaded to the sound server as soon as the context is
+ * open, so that notes never wait for them to be read from disk */
+static const struct
+{
+    const gchar *sample;
+    const gchar *event_id;
+} cached_sounds[] = {
+    { HILDON_SOUND_INFORMATION_NOTE,  "hildon-information-note" },
+    { HILDON_SOUND_CONFIRMATION_NOTE, "hildon-confirmation-note" }
+};
+
+/* hildon_play_system_sound() may be called from any thread, all of
+ * them are protected by the sound lock */
+G_LOCK_DEFINE_STATIC (sound);
+static ca_context *context = NULL;
+static HildonSoundContextState context_state = CONTEXT_CLOSED;
+static gchar *pending_sample = NULL;
+static gint64 context_failed_time = 0;
+static GHashTable *sounds = NULL;
+
+static ca_proplist *
+hildon_sound_proplist_new (const gchar *sample,
+                           const gchar *event_id)
+{
+    ca_proplist *pl = NULL;
 
-/*
- * hildon_ca_context_get:
- *
- * hildon maintains a single application-global ca_context object.
- *
- * This functions is based on ca_gtk_context_get
- *
- * Returns: a ca_context object
- */
-static ca_context *
-hildon_ca_context_get (void)
+    ca_proplist_create(&pl);
+    ca_proplist_sets(pl, CA_PROP_MEDIA_FILENAME, sample);
+    ca_proplist_sets(pl, CA_PROP_MEDIA_ROLE, "dialog-information");
+    ca_proplist_sets(pl, "module-stream-restore.id", "x-maemo-system-sound");
+    if (event_id)
+        ca_proplist_sets(pl, CA_PROP_EVENT_ID, event_id);
+
+    return pl;
+}
+
+/* The properties to play @sample with, built once per sample. The
+ * cached ones are played by event id, media.filename is only used
+ * if the sound server dropped them from its cache. Called with the
+ * sound lock held, the proplists are never freed. */
+static ca_proplist *
+hildon_sound_get_proplist (const gchar *sample)
 {
-    static GStaticPrivate context_private = G_STATIC_PRIVATE_INIT;
+    ca_proplist *pl;
+    guint i;
+
+    if (G_UNLIKELY (sounds == NULL)) {
+        sounds = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                        (GDestroyNotify) ca_proplist_destroy);
+        for (i = 0; i < G_N_ELEMENTS (cached_sounds); i++)
+            g_hash_table_insert (sounds, g_strdup (cached_sounds[i].sample),
+                                 hildon_sound_proplist_new (cached_sounds[i].sample,
+                                                            cached_sounds[i].event_id));
+    }
+
+    pl = g_hash_table_lookup (sounds, sample);
+    if (pl == NULL) {
+        pl = hildon_sound_proplist_new (sample, NULL);
+        g_hash_table_insert (sounds, g_strdup (sample), pl);
+    }
+
+    return pl;
+}
+
+/* Opening the context connects to the sound server and caching
+ * uploads the samples to it, both block, so they are done in a
+ * thread of their own. */
+static gpointer
+hildon_sound_open_context (gpointer data)
+{
+    gchar *name = data;
     ca_context *c = NULL;
-    const gchar *name = NULL;
+    ca_proplist *pl;
     gint ret;
-
-    if ((c = g_static_private_get(&context_private)))
-        return c;
+    guint i;
 
     if ((ret = ca_context_create(&c)) != CA_SUCCESS) {
         g_warning("ca_context_create: %s\n", ca_strerror(ret));
-        return NULL;
-    }
-    if ((ret = ca_context_open(c)) != CA_SUCCESS) {
+        c = NULL;
+    } else if ((ret = ca_context_open(c)) != CA_SUCCESS) {
         g_warning("ca_context_open: %s\n", ca_strerror(ret));
         ca_context_destroy(c);
-        return NULL;
+        c = NULL;
+    }
+
+    if (c) {
+        if (name)
+            ca_context_change_props(c, CA_PROP_APPLICATION_NAME, name, NULL);
+
+        for (i = 0; i < G_N_ELEMENTS (cached_sounds); i++) {
+            pl = hildon_sound_proplist_new (cached_sounds[i].sample,
+                                            cached_sounds[i].event_id);
+            if ((ret = ca_context_cache_full(c, pl)) != CA_SUCCESS)
+                g_warning("ca_context_cache_full: %s\n", ca_strerror(ret));
+            ca_proplist_destroy(pl);
+        }
     }
 
-    if ((name = g_get_application_name()))
-        ca_context_change_props(c, CA_PROP_APPLICATION_NAME, name, NULL);
+    g_free (name);
+
+    /* Play the sound requested meanwhile from here, ca_context is
+     * thread safe and nothing has to wait for a main loop */
+    G_LOCK (sound);
+    context = c;
+    context_state = c ? CONTEXT_READY : CONTEXT_CLOSED;
+    context_failed_time = c ? 0 : g_get_monotonic_time ();
+    pl = NULL;
+    if (pending_sample) {
+        if (c)
+            pl = hildon_sound_get_proplist (pending_sample);
+        g_free (pending_sample);
+        pending_sample = NULL;
+    }
+    G_UNLOCK (sound);
+
+    if (pl)
+        ca_context_play_full(c, 0, pl, NULL, NULL);
+
+    return NULL;
+}
+
+/*
+ * hildon_sound_init:
+ *
+ * hildon maintains a single application-global ca_context object.
+ * This starts opening it in a thread, and is called by hildon_init().
+ * Sounds played before it is ready are played by that thread once the
+ * context is open, only the last one is kept. If it can't be opened,
+ * playing a sound tries again, at most every few seconds.
+ *
+ * This functions is based on ca_gtk_context_get
+ */
+static void
+hildon_sound_init_unlocked (void)
+{
+    gchar *name;
+
+    if (context_state != CONTEXT_CLOSED)
+        return;
 
-    g_static_private_set(&context_private, c, (GDestroyNotify) ca_context_destroy);
+    context_state = CONTEXT_OPENING;
+    name = g_strdup (g_get_application_name());
 
-    return c;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    g_thread_unref (g_thread_new ("hildon-sound", hildon_sound_open_context, name));
+#else
+    g_thread_create (hildon_sound_open_context, name, FALSE, NULL);
+#endif
+}
+
+void
+hildon_sound_init (void)
+{
+    G_LOCK (sound);
+    hildon_sound_init_unlocked ();
+    G_UNLOCK (sound);
 }
 
 /**
@@ -93,17 +223,31 @@ hildon_ca_context_get (void)
 void 
 hildon_play_system_sound(const gchar *sample)
 {
-    ca_context *ca_con = NULL;
     ca_proplist *pl = NULL;
 
-    ca_con = hildon_ca_context_get ();
-
-    ca_proplist_create(&pl);
-    ca_proplist_sets(pl, CA_PROP_MEDIA_FILENAME, sample);
-    ca_proplist_sets(pl, CA_PROP_MEDIA_ROLE, "dialog-information");
-    ca_proplist_sets(pl, "module-stream-restore.id", "x-maemo-system-sound");
-
-    ca_context_play_full(ca_con, 0, pl, NULL, NULL);
+    g_return_if_fail (sample != NULL);
+
+    G_LOCK (sound);
+    switch (context_state) {
+    case CONTEXT_CLOSED:
+        /* Don't retry for every sound if the server is down */
+        if (context_failed_time != 0 &&
+            g_get_monotonic_time () - context_failed_time < CONTEXT_RETRY_INTERVAL)
+            break;
+        hildon_sound_init_unlocked ();
+        /* fall through */
+    case CONTEXT_OPENING:
+        g_free (pending_sample);
+        pending_sample = g_strdup (sample);
+        break;
+
+    case CONTEXT_READY:
+        pl = hildon_sound_get_proplist (sample);
+        break;
+    }
+    G_UNLOCK (sound);
 
-    ca_proplist_destroy(pl);
+    /* The context never changes once it is ready */
+    if (pl)
+        ca_context_play_full(context, 0, pl, NULL, NULL);
 }
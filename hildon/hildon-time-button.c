@@ -26,24 +26,31 @@
  */
 
 #include <libintl.h>
+#include <time.h>
 
 #include "hildon-time-selector.h"
+#include "hildon-time-selector-private.h"
 #include "hildon-touch-selector.h"
 #include "hildon-picker-button.h"
+#include "hildon-picker-button-private.h"
 #include "hildon-time-button.h"
 #include "hildon-stock.h"
 
 G_DEFINE_TYPE (HildonTimeButton, hildon_time_button, HILDON_TYPE_PICKER_BUTTON)
 
-#if 0
 #define GET_PRIVATE(o)                                                  \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), HILDON_TYPE_TIME_BUTTON, HildonTimeButtonPrivate))
 typedef struct _HildonTimeButtonPrivate HildonTimeButtonPrivate;
 
+/* The selector is only built when it is needed, until then the
+ * time is kept here, already rounded down to the minutes step. */
 struct _HildonTimeButtonPrivate
 {
+  guint minutes_step;
+
+  guint hours;
+  guint minutes;
 };
-#endif
 
 #if 0
 static void
@@ -67,6 +74,31 @@ hildon_time_button_set_property (GObject * object, guint property_id,
 }
 #endif
 
+static HildonTouchSelector *
+hildon_time_button_create_selector (HildonPickerButton *button)
+{
+  HildonTimeButtonPrivate *priv = GET_PRIVATE (button);
+  GtkWidget *selector;
+
+  selector = hildon_time_selector_new_step (priv->minutes_step);
+  hildon_time_selector_set_time (HILDON_TIME_SELECTOR (selector),
+                                 priv->hours, priv->minutes);
+
+  return HILDON_TOUCH_SELECTOR (selector);
+}
+
+static void
+hildon_time_button_show_time (HildonTimeButton *button)
+{
+  HildonTimeButtonPrivate *priv = GET_PRIVATE (button);
+  gchar *time;
+
+  time = hildon_time_selector_format_time (priv->hours, priv->minutes,
+                                           hildon_time_selector_get_automatic_ampm_format ());
+  hildon_button_set_value (HILDON_BUTTON (button), time);
+  g_free (time);
+}
+
 static GObject *
 hildon_time_button_constructor (GType type,
                                 guint n_construct_params,
@@ -88,9 +120,9 @@ hildon_time_button_class_init (HildonTimeButtonClass * klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->constructor = hildon_time_button_constructor;
-#if 0
-  g_type_class_add_private (klass, sizeof (HildonTimeButtonPrivate));
 
+  g_type_class_add_private (klass, sizeof (HildonTimeButtonPrivate));
+#if 0
   object_class->get_property = hildon_time_button_get_property;
   object_class->set_property = hildon_time_button_set_property;
 #endif
@@ -138,12 +170,32 @@ hildon_time_button_new_step (HildonSizeType          size,
                              HildonButtonArrangement arrangement,
                              guint                   minutes_step)
 {
-  return g_object_new (HILDON_TYPE_TIME_BUTTON,
-                       "title", HILDON_STOCK_TIME,
-                       "arrangement", arrangement,
-                       "size", size,
-                       "touch-selector", hildon_time_selector_new_step (minutes_step),
-                       NULL);
+  GtkWidget *button;
+  HildonTimeButtonPrivate *priv;
+  time_t secs;
+  struct tm *tm;
+
+  g_return_val_if_fail (minutes_step >= 1 && minutes_step <= 30, NULL);
+
+  /* The selector itself is built when first needed */
+  button = g_object_new (HILDON_TYPE_TIME_BUTTON,
+                         "title", HILDON_STOCK_TIME,
+                         "arrangement", arrangement,
+                         "size", size,
+                         NULL);
+
+  priv = GET_PRIVATE (button);
+  secs = time (NULL);
+  tm = localtime (&secs);
+  priv->minutes_step = minutes_step;
+  priv->hours = tm->tm_hour;
+  priv->minutes = tm->tm_min - tm->tm_min % minutes_step;
+
+  hildon_picker_button_set_selector_func (HILDON_PICKER_BUTTON (button),
+                                          hildon_time_button_create_selector);
+  hildon_time_button_show_time (HILDON_TIME_BUTTON (button));
+
+  return button;
 }
 
 /**
@@ -161,10 +213,21 @@ hildon_time_button_get_time (HildonTimeButton * button,
                              guint * hours, guint * minutes)
 {
   HildonTouchSelector *selector;
+  HildonTimeButtonPrivate *priv;
 
   g_return_if_fail (HILDON_IS_TIME_BUTTON (button));
 
-  selector = hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
+  selector = hildon_picker_button_peek_selector (HILDON_PICKER_BUTTON (button));
+  priv = GET_PRIVATE (button);
+
+  /* The selector is still deferred */
+  if (selector == NULL && priv->minutes_step > 0) {
+    if (hours != NULL)
+      *hours = priv->hours;
+    if (minutes != NULL)
+      *minutes = priv->minutes;
+    return;
+  }
 
   hildon_time_selector_get_time (HILDON_TIME_SELECTOR (selector), hours, minutes);
 }
@@ -185,10 +248,24 @@ hildon_time_button_set_time (HildonTimeButton * button,
                              guint hours, guint minutes)
 {
   HildonTouchSelector *selector;
+  HildonTimeButtonPrivate *priv;
   gchar *time;
 
   g_return_if_fail (HILDON_IS_TIME_BUTTON (button));
 
+  selector = hildon_picker_button_peek_selector (HILDON_PICKER_BUTTON (button));
+  priv = GET_PRIVATE (button);
+
+  /* The selector is still deferred */
+  if (selector == NULL && priv->minutes_step > 0 &&
+      hours <= 23 && minutes <= 59) {
+    priv->hours = hours;
+    priv->minutes = minutes - minutes % priv->minutes_step;
+    hildon_time_button_show_time (button);
+    hildon_picker_button_value_changed (HILDON_PICKER_BUTTON (button));
+    return;
+  }
+
   selector = hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (button));
 
   hildon_time_selector_set_time (HILDON_TIME_SELECTOR (selector), hours, minutes);
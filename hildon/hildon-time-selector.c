@@ -49,7 +49,9 @@
 
 #include "hildon-enum-types.h"
 #include "hildon-time-selector.h"
+#include "hildon-time-selector-private.h"
 #include "hildon-touch-selector-private.h"
+#include "hildon-date-time-models-private.h"
 
 #define HILDON_TIME_SELECTOR_GET_PRIVATE(obj)                           \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_TIME_SELECTOR, HildonTimeSelectorPrivate))
@@ -68,8 +70,8 @@ G_DEFINE_TYPE (HildonTimeSelector, hildon_time_selector, HILDON_TYPE_TOUCH_SELEC
 #define CLOCK_GCONF_IS_24H_FORMAT CLOCK_GCONF_PATH  "/time-format"
 
 enum {
-  COLUMN_STRING,
-  COLUMN_INT,
+  COLUMN_STRING = HILDON_DATE_TIME_MODEL_COLUMN_STRING,
+  COLUMN_INT = HILDON_DATE_TIME_MODEL_COLUMN_INT,
   TOTAL_MODEL_COLUMNS
 };
 
@@ -117,10 +119,6 @@ static void hildon_time_selector_set_property (GObject *object,
                                                GParamSpec *pspec);
 
 /* private functions */
-static GtkTreeModel *_create_hours_model (HildonTimeSelector * selector);
-static GtkTreeModel *_create_minutes_model (guint minutes_step);
-static GtkTreeModel *_create_ampm_model (HildonTimeSelector * selector);
-
 static void _get_real_time (gint * hours, gint * minutes);
 static void _manage_ampm_selection_cb (HildonTouchSelector * selector,
                                        gint num_column, gpointer data);
@@ -206,7 +204,7 @@ hildon_time_selector_constructor (GType type,
 
   g_object_set (object, "live-search", FALSE, NULL);
 
-  selector->priv->hours_model = _create_hours_model (selector);
+  selector->priv->hours_model = hildon_date_time_models_get_hours (selector->priv->ampm_format);
 
   column = hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                                      selector->priv->hours_model, TRUE);
@@ -215,14 +213,14 @@ hildon_time_selector_constructor (GType type,
   /* we need initialization parameters in order to create minute models*/
   selector->priv->minutes_step = selector->priv->minutes_step ? selector->priv->minutes_step : 1;
 
-  selector->priv->minutes_model = _create_minutes_model (selector->priv->minutes_step);
+  selector->priv->minutes_model = hildon_date_time_models_get_minutes (selector->priv->minutes_step);
 
   column = hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                                      selector->priv->minutes_model, TRUE);
   hildon_touch_selector_column_set_text_column (column, 0);
 
   if (selector->priv->ampm_format) {
-    selector->priv->ampm_model = _create_ampm_model (selector);
+    selector->priv->ampm_model = hildon_date_time_models_get_ampm ();
 
     hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                               selector->priv->ampm_model, TRUE);
@@ -335,10 +333,7 @@ static gchar *
 _custom_print_func (HildonTouchSelector * touch_selector,
                     gpointer user_data)
 {
-  gchar *result = NULL;
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
   HildonTimeSelector *selector = NULL;
-  static gchar string[255];
   guint hours = 0;
   guint minutes = 0;
 
@@ -346,107 +341,8 @@ _custom_print_func (HildonTouchSelector * touch_selector,
 
   hildon_time_selector_get_time (selector, &hours, &minutes);
 
-  tm.tm_min = minutes;
-  tm.tm_hour = hours;
-
-  if (selector->priv->ampm_format) {
-    if (selector->priv->pm) {
-      strftime (string, 255, _("wdgt_va_12h_time_pm"), &tm);
-    } else {
-      strftime (string, 255, _("wdgt_va_12h_time_am"), &tm);
-    }
-  } else {
-    strftime (string, 255, _("wdgt_va_24h_time"), &tm);
-  }
-
-
-  result = g_strdup (string);
-
-  return result;
-}
-
-static GtkTreeModel *
-_create_minutes_model (guint minutes_step)
-{
-  GtkListStore *store_minutes = NULL;
-  gint i = 0;
-  static gchar label[255];
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  GtkTreeIter iter;
-
-  store_minutes = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = 0; i <= 59; i=i+minutes_step) {
-    tm.tm_min = i;
-    strftime (label, 255, _("wdgt_va_minutes"), &tm);
-
-    gtk_list_store_append (store_minutes, &iter);
-    gtk_list_store_set (store_minutes, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, i, -1);
-  }
-
-  return GTK_TREE_MODEL (store_minutes);
-}
-
-static GtkTreeModel *
-_create_hours_model (HildonTimeSelector * selector)
-{
-  GtkListStore *store_hours = NULL;
-  gint i = 0;
-  GtkTreeIter iter;
-  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-  static gchar label[255];
-  static gint range_12h[12] = {12, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11};
-  static gint range_24h[24] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,
-                               12,13,14,15,16,17,18,19,20,21,22,23};
-  gint *range = NULL;
-  gint num_elements = 0;
-  gchar *format_string = NULL;
-
-  if (selector->priv->ampm_format) {
-    range = range_12h;
-    num_elements = 12;
-    format_string = N_("wdgt_va_12h_hours");
-  } else {
-    range = range_24h;
-    num_elements = 24;
-    format_string = N_("wdgt_va_24h_hours");
-  }
-
-  store_hours = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-  for (i = 0; i < num_elements; i++) {
-    tm.tm_hour = range[i];
-    strftime (label, 255, _(format_string), &tm);
-
-    gtk_list_store_append (store_hours, &iter);
-    gtk_list_store_set (store_hours, &iter,
-                        COLUMN_STRING, label, COLUMN_INT, range[i], -1);
-  }
-
-  return GTK_TREE_MODEL (store_hours);
-}
-
-static GtkTreeModel *
-_create_ampm_model (HildonTimeSelector * selector)
-{
-  GtkListStore *store_ampm = NULL;
-  GtkTreeIter iter;
-  static gchar label[255];
-
-  store_ampm = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
-
-  snprintf (label, 255, _("wdgt_va_am"));
-  gtk_list_store_append (store_ampm, &iter);
-  gtk_list_store_set (store_ampm, &iter,
-                      COLUMN_STRING, label,
-                      COLUMN_INT, 0, -1);
-
-  snprintf (label, 255, _("wdgt_va_pm"));
-  gtk_list_store_append (store_ampm, &iter);
-  gtk_list_store_set (store_ampm, &iter,
-                      COLUMN_STRING, label,
-                      COLUMN_INT, 1, -1);
-
-  return GTK_TREE_MODEL (store_ampm);
+  return hildon_time_selector_format_time (hours, minutes,
+                                           selector->priv->ampm_format);
 }
 
 static void
@@ -489,6 +385,13 @@ _manage_ampm_selection_cb (HildonTouchSelector * touch_selector,
 
 static void
 check_automatic_ampm_format (HildonTimeSelector * selector)
+{
+  selector->priv->ampm_format = hildon_time_selector_get_automatic_ampm_format ();
+}
+
+/* Whether the clock settings ask for the am/pm format */
+G_GNUC_INTERNAL gboolean
+hildon_time_selector_get_automatic_ampm_format (void)
 {
   GConfClient *client = NULL;
   gboolean value = TRUE;
@@ -505,7 +408,30 @@ check_automatic_ampm_format (HildonTimeSelector * selector)
 
   g_object_unref (client);
 
-  selector->priv->ampm_format = !value;
+  return !value;
+}
+
+/* Formats a time the way the selector prints it, without building one */
+G_GNUC_INTERNAL gchar *
+hildon_time_selector_format_time (guint hours, guint minutes, gboolean ampm_format)
+{
+  gchar string[255];
+  struct tm tm = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+  tm.tm_min = minutes;
+  tm.tm_hour = hours;
+
+  if (ampm_format) {
+    if (hours >= 12) {
+      strftime (string, 255, _("wdgt_va_12h_time_pm"), &tm);
+    } else {
+      strftime (string, 255, _("wdgt_va_12h_time_am"), &tm);
+    }
+  } else {
+    strftime (string, 255, _("wdgt_va_24h_time"), &tm);
+  }
+
+  return g_strdup (string);
 }
 
 static void
@@ -575,7 +501,7 @@ update_format_dependant_columns                 (HildonTimeSelector *selector,
   if (selector->priv->hours_model) {
     g_object_unref (selector->priv->hours_model);
   }
-  selector->priv->hours_model = _create_hours_model (selector);
+  selector->priv->hours_model = hildon_date_time_models_get_hours (selector->priv->ampm_format);
   hildon_touch_selector_set_model (HILDON_TOUCH_SELECTOR (selector),
                                    0,
                                    selector->priv->hours_model);
@@ -594,7 +520,7 @@ update_format_dependant_columns                 (HildonTimeSelector *selector,
     g_object_unref (selector->priv->ampm_model);
   }
   if (selector->priv->ampm_format) {
-    selector->priv->ampm_model = _create_ampm_model (selector);
+    selector->priv->ampm_model = hildon_date_time_models_get_ampm ();
 
     hildon_touch_selector_append_text_column (HILDON_TOUCH_SELECTOR (selector),
                                               selector->priv->ampm_model, TRUE);
@@ -55,6 +55,8 @@
 #include "hildon-touch-selector-private.h"
 #include "hildon-touch-selector-entry.h"
 #include "hildon-entry.h"
+#include "hildon-helper.h"
+#include "hildon-smart-match.h"
 
 #include <string.h>
 
@@ -77,11 +79,31 @@ static void
 _text_column_modified (GObject *pspec, GParamSpec *gobject, gpointer data);
 
 
+/* The rows of the model with some text, sorted by it. The segment
+   tree in first gives the first row, in model order, of any range of
+   sorted rows, so the row that a linear scan would find is found in
+   logarithmic time. */
+typedef struct {
+  const gchar **texts;          /* by row, NULL for rows without text */
+  gboolean fold;                /* compare ignoring ASCII case */
+  guint n_sorted;
+  guint *sorted;
+  guint *first;
+} CompletionOrder;
+
 struct _HildonTouchSelectorEntryPrivate {
   gulong signal_id;
   GtkWidget *entry;
-  GIConv converter;
   gboolean smart_match;
+
+  /* Completion index, rebuilt after any change in the model */
+  GtkTreeModel *index_model;
+  gint index_column;
+  gulong index_handlers[4];
+  GStringChunk *index_chunk;
+  CompletionOrder raw;
+  HildonNormalizedStrings *index_folded;
+  CompletionOrder folded;
 };
 
 enum {
@@ -132,6 +154,208 @@ hildon_touch_selector_entry_set_property (GObject *object, guint property_id,
   }
 }
 
+static gint
+completion_text_compare (const gchar *a,
+                         const gchar *b,
+                         gboolean fold)
+{
+  return fold ? g_ascii_strcasecmp (a, b) : strcmp (a, b);
+}
+
+static gint
+completion_order_sort_func (gconstpointer a,
+                            gconstpointer b,
+                            gpointer user_data)
+{
+  CompletionOrder *order = user_data;
+  guint ra = *(const guint *) a;
+  guint rb = *(const guint *) b;
+  gint ret = completion_text_compare (order->texts[ra], order->texts[rb], order->fold);
+
+  if (ret == 0)
+    ret = (ra > rb) - (ra < rb);
+
+  return ret;
+}
+
+/* Takes ownership of texts, which has n_rows elements */
+static void
+completion_order_init (CompletionOrder *order,
+                       const gchar **texts,
+                       guint n_rows,
+                       gboolean fold)
+{
+  guint row, i;
+
+  order->texts = texts;
+  order->fold = fold;
+  order->sorted = g_new (guint, n_rows);
+  order->n_sorted = 0;
+
+  for (row = 0; row < n_rows; row++) {
+    if (texts[row] != NULL)
+      order->sorted[order->n_sorted++] = row;
+  }
+
+  g_qsort_with_data (order->sorted, order->n_sorted, sizeof (guint),
+                     completion_order_sort_func, order);
+
+  order->first = g_new (guint, 2 * order->n_sorted);
+  for (i = 0; i < order->n_sorted; i++)
+    order->first[order->n_sorted + i] = order->sorted[i];
+  for (i = order->n_sorted; i-- > 1;)
+    order->first[i] = MIN (order->first[2 * i], order->first[2 * i + 1]);
+}
+
+static void
+completion_order_clear (CompletionOrder *order)
+{
+  g_free (order->texts);
+  g_free (order->sorted);
+  g_free (order->first);
+  memset (order, 0, sizeof (CompletionOrder));
+}
+
+/* Returns the first row, in model order, whose text starts with
+   prefix, or -1 */
+static gint
+completion_order_lookup (CompletionOrder *order,
+                         const gchar *prefix)
+{
+  gsize len = strlen (prefix);
+  guint lo = 0, hi = order->n_sorted, first;
+  guint row = G_MAXUINT;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (completion_text_compare (order->texts[order->sorted[mid]], prefix, order->fold) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  first = lo;
+
+  /* The rows starting with prefix come right after it */
+  hi = order->n_sorted;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    const gchar *text = order->texts[order->sorted[mid]];
+
+    if ((order->fold ? g_ascii_strncasecmp (text, prefix, len) : strncmp (text, prefix, len)) == 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  for (first += order->n_sorted, lo += order->n_sorted; first < lo; first >>= 1, lo >>= 1) {
+    if (first & 1) {
+      row = MIN (row, order->first[first]);
+      first++;
+    }
+    if (lo & 1) {
+      lo--;
+      row = MIN (row, order->first[lo]);
+    }
+  }
+
+  return row == G_MAXUINT ? -1 : (gint) row;
+}
+
+static void
+completion_index_drop (HildonTouchSelectorEntry *selector)
+{
+  HildonTouchSelectorEntryPrivate *priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (selector);
+  guint i;
+
+  if (priv->index_model == NULL)
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (priv->index_handlers); i++)
+    g_signal_handler_disconnect (priv->index_model, priv->index_handlers[i]);
+  g_object_unref (priv->index_model);
+  priv->index_model = NULL;
+
+  completion_order_clear (&priv->raw);
+  completion_order_clear (&priv->folded);
+  g_string_chunk_free (priv->index_chunk);
+  priv->index_chunk = NULL;
+  hildon_normalized_strings_free (priv->index_folded);
+  priv->index_folded = NULL;
+}
+
+static void
+completion_index_build (HildonTouchSelectorEntry *selector,
+                        GtkTreeModel *model,
+                        gint text_column)
+{
+  HildonTouchSelectorEntryPrivate *priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (selector);
+  const gchar **texts;
+  GtkTreeIter iter;
+  guint n_rows, row = 0;
+
+  completion_index_drop (selector);
+
+  priv->index_model = g_object_ref (model);
+  priv->index_column = text_column;
+
+  /* Any change makes the whole index stale, it is built again on
+     the next keystroke */
+  priv->index_handlers[0] = g_signal_connect_swapped (model, "row-changed",
+                                                      G_CALLBACK (completion_index_drop), selector);
+  priv->index_handlers[1] = g_signal_connect_swapped (model, "row-inserted",
+                                                      G_CALLBACK (completion_index_drop), selector);
+  priv->index_handlers[2] = g_signal_connect_swapped (model, "row-deleted",
+                                                      G_CALLBACK (completion_index_drop), selector);
+  priv->index_handlers[3] = g_signal_connect_swapped (model, "rows-reordered",
+                                                      G_CALLBACK (completion_index_drop), selector);
+
+  n_rows = gtk_tree_model_iter_n_children (model, NULL);
+  texts = g_new0 (const gchar *, n_rows);
+  priv->index_chunk = g_string_chunk_new (1024);
+
+  if (gtk_tree_model_get_iter_first (model, &iter)) {
+    do {
+      gchar *text;
+
+      gtk_tree_model_get (model, &iter, text_column, &text, -1);
+      if (text != NULL)
+        texts[row] = g_string_chunk_insert (priv->index_chunk, text);
+      g_free (text);
+      row++;
+    } while (row < n_rows && gtk_tree_model_iter_next (model, &iter));
+  }
+
+  completion_order_init (&priv->raw, texts, n_rows, FALSE);
+}
+
+/* The ASCII-folded order is only needed in smart match mode */
+static void
+completion_index_build_folded (HildonTouchSelectorEntry *selector)
+{
+  HildonTouchSelectorEntryPrivate *priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (selector);
+  const gchar **texts;
+  guint n_rows, row;
+
+  priv->index_folded = hildon_normalized_strings_new_from_model (priv->index_model,
+                                                                 priv->index_column);
+  n_rows = hildon_normalized_strings_get_length (priv->index_folded);
+
+  texts = g_new (const gchar *, n_rows);
+  for (row = 0; row < n_rows; row++)
+    texts[row] = hildon_normalized_strings_get (priv->index_folded, row);
+
+  completion_order_init (&priv->folded, texts, n_rows, TRUE);
+}
+
+static void
+hildon_touch_selector_entry_dispose (GObject *object)
+{
+  completion_index_drop (HILDON_TOUCH_SELECTOR_ENTRY (object));
+
+  G_OBJECT_CLASS (hildon_touch_selector_entry_parent_class)->dispose (object);
+}
+
 static GObject *
 hildon_touch_selector_entry_constructor (GType type,
 					 guint n_construct_properties,
@@ -147,15 +371,6 @@ hildon_touch_selector_entry_constructor (GType type,
   return object;
 }
 
-static void
-hildon_touch_selector_entry_finalize (GObject *object)
-{
-  HildonTouchSelectorEntryPrivate *priv;
-  priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (object);
-  g_iconv_close (priv->converter);
-  G_OBJECT_CLASS (hildon_touch_selector_entry_parent_class)->finalize (object);
-}
-
 static void
 hildon_touch_selector_entry_class_init (HildonTouchSelectorEntryClass *klass)
 {
@@ -168,9 +383,9 @@ hildon_touch_selector_entry_class_init (HildonTouchSelectorEntryClass *klass)
   selector_class->has_multiple_selection = hildon_touch_selector_entry_has_multiple_selection;
 
   object_class->constructor  = hildon_touch_selector_entry_constructor;
+  object_class->dispose      = hildon_touch_selector_entry_dispose;
   object_class->get_property = hildon_touch_selector_entry_get_property;
   object_class->set_property = hildon_touch_selector_entry_set_property;
-  object_class->finalize     = hildon_touch_selector_entry_finalize;
 
   /**
    * HildonTouchSelectorEntry:smart-match:
@@ -228,8 +443,6 @@ hildon_touch_selector_entry_init (HildonTouchSelectorEntry *self)
 
   priv = HILDON_TOUCH_SELECTOR_ENTRY_GET_PRIVATE (self);
 
-  priv->converter = g_iconv_open ("ascii//translit", "utf-8");
-
   priv->entry = hildon_entry_new (HILDON_SIZE_FINGER_HEIGHT);
   gtk_entry_set_activates_default (GTK_ENTRY (priv->entry), TRUE);
 
@@ -384,11 +597,9 @@ entry_on_text_changed (GtkEditable * editable,
   GtkTreeIter iter_suggested;
   GtkEntry *entry;
   const gchar *prefix;
-  gchar *text;
   gboolean found = FALSE;
   gint text_column = -1;
-  gchar *ascii_prefix;
-  gint prefix_len;
+  gint row;
   gboolean found_suggestion = FALSE;
 
   entry = GTK_ENTRY (editable);
@@ -410,29 +621,28 @@ entry_on_text_changed (GtkEditable * editable,
     return;
   }
 
-  if (priv->smart_match) {
-    ascii_prefix = g_convert_with_iconv (prefix, -1, priv->converter, NULL, NULL, NULL);
-    prefix_len = strlen (ascii_prefix);
+  if (priv->index_model != model || priv->index_column != text_column) {
+    completion_index_build (HILDON_TOUCH_SELECTOR_ENTRY (selector), model, text_column);
   }
 
-  do {
-    gtk_tree_model_get (model, &iter, text_column, &text, -1);
-    found = g_str_has_prefix (text, prefix);
-
-    if (!found && !found_suggestion && priv->smart_match) {
-      gchar *ascii_text = g_convert_with_iconv (text, -1, priv->converter, NULL, NULL, NULL);
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wuninitialized"
-      found_suggestion = !g_ascii_strncasecmp (ascii_text, ascii_prefix, prefix_len);
-#pragma GCC diagnostic pop
-      if (found_suggestion) {
-        iter_suggested = iter;
+  /* The first row starting with the text, or else the first one
+     starting with it after normalizing both and ignoring case */
+  row = completion_order_lookup (&priv->raw, prefix);
+  found = row >= 0 && gtk_tree_model_iter_nth_child (model, &iter, NULL, row);
+
+  if (!found && priv->smart_match) {
+    gchar *ascii_prefix = hildon_helper_normalize_string (prefix);
+
+    if (ascii_prefix != NULL) {
+      if (priv->index_folded == NULL) {
+        completion_index_build_folded (HILDON_TOUCH_SELECTOR_ENTRY (selector));
       }
-      g_free (ascii_text);
+      row = completion_order_lookup (&priv->folded, ascii_prefix);
+      found_suggestion = row >= 0 &&
+        gtk_tree_model_iter_nth_child (model, &iter_suggested, NULL, row);
+      g_free (ascii_prefix);
     }
-
-    g_free (text);
-  } while (found != TRUE && gtk_tree_model_iter_next (model, &iter));
+  }
 
   g_signal_handler_block (selector, priv->signal_id);
   {
@@ -447,13 +657,6 @@ entry_on_text_changed (GtkEditable * editable,
     g_signal_emit_by_name (selector, "changed", 0);
   }
   g_signal_handler_unblock (selector, priv->signal_id);
-
-  if (priv->smart_match) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wuninitialized"
-    g_free (ascii_prefix);
-#pragma GCC diagnostic pop
-  }
 }
 
 /* FIXME: This is actually a very ugly way to retrieve the text. Ideally,
@@ -34,6 +34,18 @@ hildon_touch_selector_unblock_changed           (HildonTouchSelector *selector);
 void G_GNUC_INTERNAL
 hildon_touch_selector_column_disable_focus      (HildonTouchSelectorColumn *col);
 
+typedef struct _HildonTouchSelectorSnapshot     HildonTouchSelectorSnapshot;
+
+HildonTouchSelectorSnapshot * G_GNUC_INTERNAL
+hildon_touch_selector_snapshot_new              (HildonTouchSelector *selector);
+
+gboolean G_GNUC_INTERNAL
+hildon_touch_selector_snapshot_restore          (HildonTouchSelector         *selector,
+                                                 HildonTouchSelectorSnapshot *snapshot);
+
+void G_GNUC_INTERNAL
+hildon_touch_selector_snapshot_free             (HildonTouchSelectorSnapshot *snapshot);
+
 G_END_DECLS
 
 #endif
@@ -186,6 +186,7 @@
 #include "hildon-touch-selector-private.h"
 #include "hildon-live-search.h"
 #include "hildon-helper.h"
+#include "hildon-smart-match.h"
 
 #define HILDON_TOUCH_SELECTOR_GET_PRIVATE(obj)                          \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), HILDON_TYPE_TOUCH_SELECTOR, HildonTouchSelectorPrivate))
@@ -212,6 +213,14 @@ struct _HildonTouchSelectorColumnPrivate
   GtkTreeModel *filter;
   GtkWidget *livesearch;
 
+  /* Live search lookups, built on first use and dropped whenever
+     the model changes */
+  HildonSmartMatchIndex *match_index;
+  gulong match_index_handlers[4];
+  guint8 *match_rows;
+  guint n_match_rows;
+  gboolean in_refilter;
+
   GtkWidget *panarea;           /* the pannable widget */
   GtkWidget *vbox;
   GtkTreeRowReference *last_activated;
@@ -223,7 +232,7 @@ struct _HildonTouchSelectorPrivate
   GtkWidget *hbox;              /* the container for the selector's columns */
   gboolean initial_scroll;      /* whether initial fancy scrolling to selection */
   gboolean has_live_search;
-  GSList *norm_tokens;
+  HildonSmartMatcher *matcher;  /* the live search text, compiled */
 
   gboolean changed_blocked;
 
@@ -510,7 +519,7 @@ hildon_touch_selector_init (HildonTouchSelector * selector)
 
   selector->priv->columns = NULL;
 
-  selector->priv->norm_tokens = NULL;
+  selector->priv->matcher = NULL;
   selector->priv->print_func = NULL;
   selector->priv->print_user_data = NULL;
   selector->priv->print_destroy_func = NULL;
@@ -533,11 +542,8 @@ hildon_touch_selector_dispose (GObject * object)
   hildon_touch_selector_set_print_func_full (selector,
                                              NULL, NULL, NULL);
 
-  if (selector->priv->norm_tokens != NULL) {
-      g_slist_foreach (selector->priv->norm_tokens, (GFunc) g_free, NULL);
-      g_slist_free (selector->priv->norm_tokens);
-      selector->priv->norm_tokens = NULL;
-  }
+  hildon_smart_matcher_free (selector->priv->matcher);
+  selector->priv->matcher = NULL;
 
   gobject_class = G_OBJECT_CLASS (hildon_touch_selector_parent_class);
 
@@ -624,6 +630,181 @@ hildon_touch_selector_column_disable_focus      (HildonTouchSelectorColumn *col)
     gtk_widget_set_can_focus (GTK_WIDGET (col->priv->tree_view), FALSE);
 }
 
+/* The selection of every column, as the indexes of the selected rows
+   in the column model. The columns hold flat lists, so an index is
+   all a GtkTreePath would store. */
+struct _HildonTouchSelectorSnapshot
+{
+  guint n_columns;
+  GArray **rows;
+};
+
+static void
+snapshot_add_row                                (GtkTreeModel *filter,
+                                                 GtkTreePath  *path,
+                                                 GtkTreeIter  *iter,
+                                                 gpointer      data)
+{
+  GtkTreePath *child_path;
+  gint index;
+
+  child_path = gtk_tree_model_filter_convert_path_to_child_path
+    (GTK_TREE_MODEL_FILTER (filter), path);
+  if (child_path == NULL)
+    return;
+
+  index = gtk_tree_path_get_indices (child_path)[0];
+  g_array_append_val ((GArray *) data, index);
+
+  gtk_tree_path_free (child_path);
+}
+
+HildonTouchSelectorSnapshot *
+hildon_touch_selector_snapshot_new              (HildonTouchSelector *selector)
+{
+  HildonTouchSelectorSnapshot *snapshot;
+  HildonTouchSelectorColumn *column;
+  GtkTreeSelection *selection;
+  GSList *iter;
+  guint i;
+
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), NULL);
+
+  snapshot = g_slice_new (HildonTouchSelectorSnapshot);
+  snapshot->n_columns = g_slist_length (selector->priv->columns);
+  snapshot->rows = g_new (GArray *, snapshot->n_columns);
+
+  for (iter = selector->priv->columns, i = 0; iter; iter = iter->next, i++) {
+    column = HILDON_TOUCH_SELECTOR_COLUMN (iter->data);
+    selection = gtk_tree_view_get_selection (column->priv->tree_view);
+
+    snapshot->rows[i] = g_array_sized_new (FALSE, FALSE, sizeof (gint),
+                                           gtk_tree_selection_count_selected_rows (selection));
+    gtk_tree_selection_selected_foreach (selection, snapshot_add_row,
+                                         snapshot->rows[i]);
+  }
+
+  return snapshot;
+}
+
+static void
+snapshot_select_run                             (GtkTreeSelection *selection,
+                                                 GtkTreePath      *first,
+                                                 GtkTreePath      *last)
+{
+  if (first == NULL)
+    return;
+
+  if (gtk_tree_path_compare (first, last) == 0)
+    gtk_tree_selection_select_path (selection, first);
+  else
+    gtk_tree_selection_select_range (selection, first, last);
+}
+
+/* Selects every row in @rows, which come in increasing order. A run
+   of consecutive model rows is selected as a single range: the rows
+   the filter shows between the first and the last visible row of the
+   run all belong to it. */
+static void
+snapshot_restore_column                         (HildonTouchSelectorColumn *column,
+                                                 GArray                    *rows)
+{
+  GtkTreeModelFilter *filter;
+  GtkTreeSelection *selection;
+  GtkTreePath *child_path;
+  GtkTreePath *path;
+  GtkTreePath *first = NULL;
+  GtkTreePath *last = NULL;
+  gint previous = -2;
+  gint index;
+  guint i;
+
+  filter = GTK_TREE_MODEL_FILTER (column->priv->filter);
+  selection = gtk_tree_view_get_selection (column->priv->tree_view);
+
+  gtk_tree_selection_unselect_all (selection);
+
+  for (i = 0; i < rows->len; i++) {
+    index = g_array_index (rows, gint, i);
+
+    if (index != previous + 1) {
+      snapshot_select_run (selection, first, last);
+      gtk_tree_path_free (first);
+      gtk_tree_path_free (last);
+      first = last = NULL;
+    }
+    previous = index;
+
+    child_path = gtk_tree_path_new_from_indices (index, -1);
+    path = gtk_tree_model_filter_convert_child_path_to_path (filter, child_path);
+    gtk_tree_path_free (child_path);
+
+    /* Hidden by the live search, or gone from the model */
+    if (path == NULL)
+      continue;
+
+    if (first == NULL)
+      first = gtk_tree_path_copy (path);
+    gtk_tree_path_free (last);
+    last = path;
+  }
+
+  snapshot_select_run (selection, first, last);
+  gtk_tree_path_free (first);
+  gtk_tree_path_free (last);
+}
+
+/* Reapplies @snapshot in a single pass, emitting "changed" once per
+   column instead of once per selected row. Columns with nothing
+   selected in @snapshot are left as they are. Fails if the columns of
+   @selector changed since @snapshot was taken. */
+gboolean
+hildon_touch_selector_snapshot_restore          (HildonTouchSelector         *selector,
+                                                 HildonTouchSelectorSnapshot *snapshot)
+{
+  gboolean changed_blocked;
+  GSList *iter;
+  guint i;
+
+  g_return_val_if_fail (HILDON_IS_TOUCH_SELECTOR (selector), FALSE);
+  g_return_val_if_fail (snapshot != NULL, FALSE);
+
+  if (g_slist_length (selector->priv->columns) != snapshot->n_columns)
+    return FALSE;
+
+  changed_blocked = selector->priv->changed_blocked;
+  selector->priv->changed_blocked = TRUE;
+
+  for (iter = selector->priv->columns, i = 0; iter; iter = iter->next, i++) {
+    if (snapshot->rows[i]->len > 0)
+      snapshot_restore_column (HILDON_TOUCH_SELECTOR_COLUMN (iter->data),
+                               snapshot->rows[i]);
+  }
+
+  selector->priv->changed_blocked = changed_blocked;
+
+  for (i = 0; i < snapshot->n_columns; i++) {
+    if (snapshot->rows[i]->len > 0)
+      hildon_touch_selector_emit_value_changed (selector, i);
+  }
+
+  return TRUE;
+}
+
+void
+hildon_touch_selector_snapshot_free             (HildonTouchSelectorSnapshot *snapshot)
+{
+  guint i;
+
+  if (snapshot == NULL)
+    return;
+
+  for (i = 0; i < snapshot->n_columns; i++)
+    g_array_free (snapshot->rows[i], TRUE);
+  g_free (snapshot->rows);
+  g_slice_free (HildonTouchSelectorSnapshot, snapshot);
+}
+
 static void
 hildon_touch_selector_emit_value_changed        (HildonTouchSelector *selector,
                                                  gint column)
@@ -942,6 +1123,56 @@ hildon_touch_selector_column_init (HildonTouchSelectorColumn *column)
   column->priv->last_activated = NULL;
   column->priv->realize_handler = 0;
   column->priv->initial_path = NULL;
+  column->priv->match_index = NULL;
+  column->priv->match_rows = NULL;
+  column->priv->n_match_rows = 0;
+  column->priv->in_refilter = FALSE;
+}
+
+static void
+column_drop_match_index (HildonTouchSelectorColumn *column)
+{
+  guint i;
+
+  if (column->priv->match_index == NULL)
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (column->priv->match_index_handlers); i++) {
+    g_signal_handler_disconnect (column->priv->model,
+                                 column->priv->match_index_handlers[i]);
+    column->priv->match_index_handlers[i] = 0;
+  }
+
+  hildon_smart_match_index_free (column->priv->match_index);
+  column->priv->match_index = NULL;
+
+  g_free (column->priv->match_rows);
+  column->priv->match_rows = NULL;
+  column->priv->n_match_rows = 0;
+}
+
+static void
+column_build_match_index (HildonTouchSelectorColumn *column)
+{
+  GtkTreeModel *model = column->priv->model;
+
+  g_assert (column->priv->match_index == NULL);
+
+  column->priv->match_index =
+    hildon_smart_match_index_new (model, column->priv->text_column);
+
+  column->priv->match_index_handlers[0] =
+    g_signal_connect_swapped (model, "row-changed",
+                              G_CALLBACK (column_drop_match_index), column);
+  column->priv->match_index_handlers[1] =
+    g_signal_connect_swapped (model, "row-inserted",
+                              G_CALLBACK (column_drop_match_index), column);
+  column->priv->match_index_handlers[2] =
+    g_signal_connect_swapped (model, "row-deleted",
+                              G_CALLBACK (column_drop_match_index), column);
+  column->priv->match_index_handlers[3] =
+    g_signal_connect_swapped (model, "rows-reordered",
+                              G_CALLBACK (column_drop_match_index), column);
 }
 
 static gboolean
@@ -951,8 +1182,7 @@ hildon_live_search_visible_func (GtkTreeModel *model,
                                  gpointer userdata)
 {
   gboolean visible = TRUE;
-  gchar *string, *string_ascii;
-  GSList *list_iter;
+  gchar *string;
   HildonTouchSelectorColumn *col;
   HildonTouchSelector *selector;
 
@@ -960,18 +1190,26 @@ hildon_live_search_visible_func (GtkTreeModel *model,
   selector = col->priv->parent;
   gint text_column = GPOINTER_TO_INT (col->priv->text_column);
 
-  gtk_tree_model_get (model, iter, text_column, &string, -1);
-  string_ascii = hildon_helper_normalize_string (string);
-  list_iter = selector->priv->norm_tokens;
-  while (visible && list_iter) {
-    visible = (string_ascii != NULL &&
-               hildon_helper_smart_match (string_ascii,
-                                          (const gchar *)list_iter->data));
-    list_iter = list_iter->next;
+  /* While refiltering, the rows were already looked up in the index.
+     Otherwise the model is changing under us and the index is stale. */
+  if (col->priv->in_refilter && col->priv->match_rows != NULL) {
+    GtkTreePath *path = gtk_tree_model_get_path (model, iter);
+    gint row = -1;
+
+    if (gtk_tree_path_get_depth (path) == 1)
+      row = gtk_tree_path_get_indices (path)[0];
+    gtk_tree_path_free (path);
+
+    if (row >= 0 && (guint) row < col->priv->n_match_rows)
+      return col->priv->match_rows[row];
   }
 
+  if (selector->priv->matcher == NULL)
+    return TRUE;
+
+  gtk_tree_model_get (model, iter, text_column, &string, -1);
+  visible = hildon_smart_matcher_match (selector->priv->matcher, string);
   g_free (string);
-  g_free (string_ascii);
 
   return visible;
 }
@@ -981,27 +1219,56 @@ on_live_search_refilter (HildonLiveSearch *livesearch,
                          gpointer userdata)
 {
     HildonTouchSelector *selector = HILDON_TOUCH_SELECTOR (userdata);
+    HildonTouchSelectorColumn *col = NULL;
+    const gchar *text;
+    GSList *iter;
+    GArray *rows;
+    guint j;
+
+    text = hildon_live_search_get_text (livesearch);
+
+    hildon_smart_matcher_free (selector->priv->matcher);
+    selector->priv->matcher = NULL;
+    if (text != NULL && text[0] != '\0')
+      selector->priv->matcher = hildon_smart_matcher_new (text);
+
+    for (iter = selector->priv->columns; iter != NULL; iter = iter->next) {
+        if (HILDON_TOUCH_SELECTOR_COLUMN (iter->data)->priv->livesearch ==
+            GTK_WIDGET (livesearch))
+            col = HILDON_TOUCH_SELECTOR_COLUMN (iter->data);
+    }
 
-    gchar **tokens = g_strsplit (hildon_live_search_get_text (livesearch), " ", -1);
-    gchar *token;
-    gint i;
+    if (col == NULL || col->priv->text_column < 0)
+        return FALSE;
 
-    if (selector->priv->norm_tokens != NULL) {
-        g_slist_foreach (selector->priv->norm_tokens, (GFunc) g_free, NULL);
-        g_slist_free (selector->priv->norm_tokens);
-        selector->priv->norm_tokens = NULL;
+    /* Every row matches an empty text. Don't pay for the index until
+       something is typed, this runs while selectors are built too. */
+    if (selector->priv->matcher == NULL) {
+        g_free (col->priv->match_rows);
+        col->priv->match_rows = NULL;
+        col->priv->n_match_rows = 0;
+        return FALSE;
     }
 
-    for (i = 0; tokens [i] != NULL; i++) {
-        token = hildon_helper_normalize_string (tokens[i]);
-        if (token != NULL)
-            selector->priv->norm_tokens = g_slist_prepend (selector->priv->norm_tokens,
-                                                           token);
-    }
+    /* Find the matching rows in the word index, so that the visible
+       function does not have to normalize and scan every row. */
+    if (col->priv->match_index == NULL)
+        column_build_match_index (col);
 
-    g_strfreev (tokens);
+    rows = hildon_smart_match_index_lookup (col->priv->match_index, text);
 
-    return FALSE;
+    g_free (col->priv->match_rows);
+    col->priv->n_match_rows = hildon_smart_match_index_get_n_rows (col->priv->match_index);
+    col->priv->match_rows = g_new0 (guint8, col->priv->n_match_rows);
+    for (j = 0; j < rows->len; j++)
+        col->priv->match_rows[g_array_index (rows, guint, j)] = TRUE;
+    g_array_free (rows, TRUE);
+
+    col->priv->in_refilter = TRUE;
+    gtk_tree_model_filter_refilter (hildon_live_search_get_filter (livesearch));
+    col->priv->in_refilter = FALSE;
+
+    return TRUE;
 }
 
 /**
@@ -1023,6 +1290,7 @@ hildon_touch_selector_column_set_text_column (HildonTouchSelectorColumn *column,
   g_return_if_fail (HILDON_IS_TOUCH_SELECTOR_COLUMN (column));
   g_return_if_fail (text_column >= -1);
 
+  column_drop_match_index (column);
   column->priv->text_column = text_column;
 
   if (column->priv->livesearch) {
@@ -1087,6 +1355,8 @@ hildon_touch_selector_column_dispose      (GObject *object)
   HildonTouchSelectorColumnPrivate *priv =
       HILDON_TOUCH_SELECTOR_COLUMN (object)->priv;
 
+  column_drop_match_index (HILDON_TOUCH_SELECTOR_COLUMN (object));
+
   if (priv->model != NULL) {
       g_object_unref (priv->model);
       priv->model = NULL;
@@ -2240,6 +2510,8 @@ _hildon_touch_selector_set_model (HildonTouchSelector * selector,
   current_column =
     HILDON_TOUCH_SELECTOR_COLUMN (g_slist_nth_data (selector->priv->columns, column));
 
+  column_drop_match_index (current_column);
+
   if (current_column->priv->model) {
     g_signal_handlers_disconnect_by_func (current_column->priv->model,
                                           on_row_changed, selector);
@@ -86,6 +86,9 @@ hildon_window_update_title                      (HildonWindow *window);
 void G_GNUC_INTERNAL
 hildon_window_set_menu_flag                     (HildonWindow *window,
                                                  gboolean   has_menu);
+
+HildonAppMenu * G_GNUC_INTERNAL
+hildon_window_get_active_app_menu               (HildonWindow *self);
 G_END_DECLS
 
 #endif                                          /* __HILDON_WINDOW_PRIVATE_H__ */
@@ -455,6 +455,7 @@ static void
 hildon_window_map                             (GtkWidget *widget)
 {
   HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (widget);
+  HildonAppMenu *app_menu;
   g_assert (priv != NULL);
 
   if (GTK_WIDGET_CLASS (hildon_window_parent_class)->map)
@@ -465,6 +466,10 @@ hildon_window_map                             (GtkWidget *widget)
 
   if (priv->edit_toolbar != NULL && gtk_widget_get_visible (priv->edit_toolbar))
     gtk_widget_map (priv->edit_toolbar);
+
+  app_menu = hildon_window_get_active_app_menu (HILDON_WINDOW (widget));
+  if (app_menu != NULL)
+    hildon_app_menu_queue_prewarm (app_menu);
 }
 
 static void
@@ -1235,12 +1240,25 @@ static void
 hildon_window_is_topmost_notify                 (HildonWindow *window)
 {
     HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (window);
+    HildonAppMenu *app_menu;
 
     g_assert (priv);
 
+    app_menu = hildon_window_get_active_app_menu (window);
+
     if (priv->is_topmost)
     {
         hildon_window_take_common_toolbar (window);
+
+        if (app_menu)
+            hildon_app_menu_queue_prewarm (app_menu);
+    }
+    else if (app_menu && app_menu == priv->app_menu && priv->program &&
+             hildon_program_get_can_hibernate (priv->program))
+    {
+        /* The common menu of the program stays prepared, it may
+         * belong to the window that just became the topmost one */
+        hildon_app_menu_release_prewarm (app_menu);
     }
 }
 
@@ -1540,6 +1558,26 @@ hildon_window_toggle_gtk_menu                   (HildonWindow *self,
     return retvalue;
 }
 
+/*
+ * Returns the HildonAppMenu the menu key would show, if any
+ */
+HildonAppMenu * G_GNUC_INTERNAL
+hildon_window_get_active_app_menu               (HildonWindow *self)
+{
+    HildonWindowPrivate *priv = HILDON_WINDOW_GET_PRIVATE (self);
+
+    if (priv->menu)
+        return NULL;
+
+    if (priv->app_menu)
+        return priv->app_menu;
+
+    if (priv->program && !hildon_program_get_common_menu (priv->program))
+        return hildon_program_get_common_app_menu (priv->program);
+
+    return NULL;
+}
+
 static gboolean
 hildon_window_toggle_app_menu                   (HildonWindow  *self,
 						 HildonAppMenu *menu)
@@ -1976,6 +2014,9 @@ hildon_window_set_app_menu                      (HildonWindow  *self,
     }
 
     hildon_window_update_menu_flag (self, TRUE);
+
+    if (menu && gtk_widget_get_mapped (GTK_WIDGET (self)))
+        hildon_app_menu_queue_prewarm (menu);
 }
 
 /**
@@ -30,6 +30,7 @@
 #include                                        "hildon-caption.h"
 #include                                        "hildon-defines.h"
 #include                                        "hildon-helper.h"
+#include                                        "hildon-smart-match.h"
 #include                                        "hildon-enum-types.h"
 #include                                        "hildon-find-toolbar.h"
 #include                                        "hildon-edit-toolbar.h"
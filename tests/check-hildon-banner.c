@@ -0,0 +1,208 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include <hildon/hildon.h>
+
+static GtkWidget *window = NULL;
+
+static void
+fx_setup ()
+{
+    int argc = 0;
+
+    gtk_init (&argc, NULL);
+
+    window = hildon_window_new ();
+
+    fail_if (!HILDON_IS_WINDOW (window),
+             "hildon-banner: Window creation failed.");
+
+    show_test_window (window);
+}
+
+static void
+fx_teardown ()
+{
+    gtk_widget_destroy (window);
+}
+
+static void
+find_label (GtkWidget *widget,
+            gpointer   data)
+{
+    GtkWidget **label = data;
+
+    if (*label != NULL)
+        return;
+
+    if (GTK_IS_LABEL (widget))
+        *label = widget;
+    else if (GTK_IS_CONTAINER (widget))
+        gtk_container_forall (GTK_CONTAINER (widget), find_label, data);
+}
+
+/* The text currently displayed by @banner */
+static const gchar *
+get_banner_text (GtkWidget *banner)
+{
+    GtkWidget *label = NULL;
+
+    gtk_container_forall (GTK_CONTAINER (banner), find_label, &label);
+    fail_if (label == NULL, "hildon-banner: the banner has no label");
+
+    return gtk_label_get_text (GTK_LABEL (label));
+}
+
+static gboolean
+set_flag (gpointer data)
+{
+    *(gboolean *) data = TRUE;
+
+    return FALSE;
+}
+
+/* Runs the main loop until @banner is mapped */
+static void
+wait_for_map (GtkWidget *banner)
+{
+    gboolean expired = FALSE;
+    guint id;
+
+    id = g_timeout_add (2000, set_flag, &expired);
+    while (!gtk_widget_get_mapped (banner) && !expired)
+        gtk_main_iteration ();
+    if (!expired)
+        g_source_remove (id);
+
+    fail_if (!gtk_widget_get_mapped (banner),
+             "hildon-banner: the banner was never mapped");
+}
+
+/**
+   Purpose: test that new messages of a visible information banner
+   are shown at once by default.
+
+   Checks for:
+
+   - The pacing properties default to 0.
+   - A second message replaces the first one immediately.
+*/
+START_TEST (test_hildon_banner_default_pacing)
+{
+    GtkWidget *banner;
+    guint minimum_display_time, update_interval;
+
+    banner = hildon_banner_show_information (window, NULL, "one");
+    wait_for_map (banner);
+
+    /* Test 1: defaults */
+    g_object_get (banner,
+                  "minimum-display-time", &minimum_display_time,
+                  "update-interval", &update_interval,
+                  NULL);
+    fail_if (minimum_display_time != 0 || update_interval != 0,
+             "hildon-banner: pacing defaults to %u and %u ms, expected 0",
+             minimum_display_time, update_interval);
+
+    /* Test 2: the next message is shown at once */
+    fail_if (hildon_banner_show_information (window, NULL, "two") != banner,
+             "hildon-banner: a second information banner was created");
+    fail_if (strcmp (get_banner_text (banner), "two") != 0,
+             "hildon-banner: displays `%s', expected `two'",
+             get_banner_text (banner));
+
+    gtk_widget_destroy (banner);
+}
+END_TEST
+
+/**
+   Purpose: test the queue of messages of a paced information banner.
+
+   Checks for:
+
+   - A message arriving before the update interval waits.
+   - A message identical to the visible one is merged into it and
+     drops the waiting message.
+   - A waiting message is shown when the banner times out, instead
+     of being lost with the banner.
+*/
+START_TEST (test_hildon_banner_queue)
+{
+    GtkWidget *banner;
+    gboolean expired = FALSE;
+    guint id;
+
+    banner = hildon_banner_show_information (window, NULL, "one");
+    g_object_add_weak_pointer (G_OBJECT (banner), (gpointer *) &banner);
+    hildon_banner_set_timeout (HILDON_BANNER (banner), 200);
+    hildon_banner_set_update_interval (HILDON_BANNER (banner), 10000);
+    wait_for_map (banner);
+
+    /* Test 1: the second message waits */
+    hildon_banner_show_information (window, NULL, "two");
+    fail_if (strcmp (get_banner_text (banner), "one") != 0,
+             "hildon-banner: displays `%s' before the update interval",
+             get_banner_text (banner));
+
+    /* Test 2: the same message again is merged */
+    hildon_banner_show_information (window, NULL, "one");
+    fail_if (strcmp (get_banner_text (banner), "one") != 0,
+             "hildon-banner: displays `%s' after merging `one'",
+             get_banner_text (banner));
+
+    /* Test 3: the banner shows the waiting message when it times out */
+    hildon_banner_show_information (window, NULL, "three");
+
+    id = g_timeout_add (2000, set_flag, &expired);
+    while (banner != NULL && strcmp (get_banner_text (banner), "one") == 0 &&
+           !expired)
+        gtk_main_iteration ();
+    if (!expired)
+        g_source_remove (id);
+
+    fail_if (banner == NULL,
+             "hildon-banner: the banner timed out with a waiting message");
+    fail_if (strcmp (get_banner_text (banner), "three") != 0,
+             "hildon-banner: displays `%s' after timing out, expected `three'",
+             get_banner_text (banner));
+
+    gtk_widget_destroy (banner);
+}
+END_TEST
+
+Suite *create_hildon_banner_suite (void)
+{
+    Suite *s = suite_create ("HildonBanner");
+
+    TCase *tc1 = tcase_create ("hildon_banner_show_information");
+    tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
+    tcase_add_test (tc1, test_hildon_banner_default_pacing);
+    tcase_add_test (tc1, test_hildon_banner_queue);
+    suite_add_tcase (s, tc1);
+
+    return s;
+}
@@ -0,0 +1,184 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include <stdlib.h>
+#include <check.h>
+#include "test_suites.h"
+#include "check_utils.h"
+#include <hildon/hildon.h>
+
+static HildonDateSelector *selector = NULL;
+static gint day_column = -1;
+static gint month_column = -1;
+static guint day_changes = 0;
+
+static void
+on_changed (HildonTouchSelector *touch_selector,
+            gint                 column,
+            gpointer             data)
+{
+    if (column == day_column)
+        day_changes++;
+}
+
+static void
+fx_setup ()
+{
+    int argc = 0;
+    gint i;
+
+    gtk_init (&argc, NULL);
+
+    selector = HILDON_DATE_SELECTOR (hildon_date_selector_new_with_year_range (2000, 2020));
+    g_object_ref_sink (selector);
+
+    /* The column order depends on the locale, tell them by their size */
+    for (i = 0; i < 3; i++) {
+        GtkTreeModel *model;
+        gint n_rows;
+
+        model = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), i);
+        n_rows = gtk_tree_model_iter_n_children (model, NULL);
+        if (n_rows == 12)
+            month_column = i;
+        else if (n_rows >= 28 && n_rows <= 31)
+            day_column = i;
+    }
+
+    fail_if (day_column < 0 || month_column < 0,
+             "hildon-date-selector: day or month column not found");
+
+    g_signal_connect (selector, "changed", G_CALLBACK (on_changed), NULL);
+}
+
+static void
+fx_teardown ()
+{
+    g_object_unref (selector);
+}
+
+static void
+select_month (guint month)
+{
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+
+    model = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), month_column);
+    gtk_tree_model_iter_nth_child (model, &iter, NULL, month);
+    hildon_touch_selector_select_iter (HILDON_TOUCH_SELECTOR (selector),
+                                       month_column, &iter, FALSE);
+}
+
+/**
+   Purpose: test that the day column follows the length of the
+   selected month.
+
+   Cases considered:
+
+   - Moving from January 31st to February clamps the day to the 28th,
+     notifying the day column once.
+   - Moving back to a longer month shows its days again, keeping the day.
+*/
+START_TEST (test_hildon_date_selector_month_days)
+{
+    GtkTreeModel *days;
+    guint year, month, day;
+
+    hildon_date_selector_select_current_date (selector, 2010, 0, 31);
+    day_changes = 0;
+
+    days = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), day_column);
+
+    /* Test 1: a shorter month */
+    select_month (1);
+    hildon_date_selector_get_date (selector, &year, &month, &day);
+    fail_if (year != 2010 || month != 1 || day != 28,
+             "hildon-date-selector: expected 2010-1-28, got %u-%u-%u",
+             year, month, day);
+    fail_if (gtk_tree_model_iter_n_children (days, NULL) != 28,
+             "hildon-date-selector: February 2010 shows %d days",
+             gtk_tree_model_iter_n_children (days, NULL));
+    fail_if (day_changes != 1,
+             "hildon-date-selector: day column notified %u times", day_changes);
+
+    /* Test 2: a longer month */
+    select_month (2);
+    hildon_date_selector_get_date (selector, &year, &month, &day);
+    fail_if (month != 2 || day != 28,
+             "hildon-date-selector: expected 2010-2-28, got %u-%u-%u",
+             year, month, day);
+    fail_if (gtk_tree_model_iter_n_children (days, NULL) != 31,
+             "hildon-date-selector: March 2010 shows %d days",
+             gtk_tree_model_iter_n_children (days, NULL));
+}
+END_TEST
+
+/**
+   Purpose: test that the column models of a selector are its own,
+   even though their rows are shared with the other selectors.
+
+   Cases considered:
+
+   - The month models of two selectors are different objects, on top
+     of the same store.
+   - They are not list stores that could be modified.
+*/
+START_TEST (test_hildon_date_selector_models)
+{
+    HildonDateSelector *other;
+    GtkTreeModel *mine, *theirs;
+
+    other = HILDON_DATE_SELECTOR (hildon_date_selector_new_with_year_range (2000, 2020));
+    g_object_ref_sink (other);
+
+    mine = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (selector), month_column);
+    theirs = hildon_touch_selector_get_model (HILDON_TOUCH_SELECTOR (other), month_column);
+
+    /* Test 1: one model per selector, one store */
+    fail_if (mine == theirs,
+             "hildon-date-selector: two selectors share their month model");
+    fail_if (!GTK_IS_TREE_MODEL_FILTER (mine) || !GTK_IS_TREE_MODEL_FILTER (theirs),
+             "hildon-date-selector: month models are not filters");
+    fail_if (gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (mine)) !=
+             gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (theirs)),
+             "hildon-date-selector: month rows are not shared");
+
+    /* Test 2: not writable */
+    fail_if (GTK_IS_LIST_STORE (mine),
+             "hildon-date-selector: the month model can be modified");
+
+    g_object_unref (other);
+}
+END_TEST
+
+Suite *create_hildon_date_selector_suite (void)
+{
+    Suite *s = suite_create ("HildonDateSelector");
+
+    TCase *tc1 = tcase_create ("hildon_date_selector");
+    tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
+    tcase_add_test (tc1, test_hildon_date_selector_month_days);
+    tcase_add_test (tc1, test_hildon_date_selector_models);
+    suite_add_tcase (s, tc1);
+
+    return s;
+}
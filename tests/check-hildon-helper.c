@@ -23,10 +23,12 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <gtk/gtk.h>
 #include "test_suites.h"
 #include <hildon/hildon-helper.h>
+#include <hildon/hildon-smart-match.h>
 
 /* -------------------- Fixtures -------------------- */
 
@@ -159,7 +161,443 @@ START_TEST (test_hildon_helper_set_logical_color_invalid)
 }
 END_TEST
 
+/* ----- Test case for hildon_helper_smart_match -----*/
 
+/**
+ * Purpose: test smart matching of word starts
+ * Cases considered:
+ *    - Match at the start of the haystack, ignoring case
+ *    - Match at the start of a later word only
+ *    - Match in a word past the first 16 bytes of the haystack
+ *    - Needles starting with a non-alphanumeric character
+ */
+START_TEST (test_hildon_helper_smart_match_regular)
+{
+  const gchar *haystack = "Mary Brown-Jones (work)";
+  const gchar *long_haystack = "Hamalainen-Korhonen, Virtanen Makinen (home) +358";
+
+  fail_if (hildon_helper_smart_match (haystack, "mar") != haystack,
+	   "hildon-helper: \"mar\" should match at the start of \"%s\"", haystack);
+  fail_if (hildon_helper_smart_match (haystack, "JON") != haystack + 11,
+	   "hildon-helper: \"JON\" should match \"Jones\" in \"%s\"", haystack);
+  fail_if (hildon_helper_smart_match (haystack, "ones") != NULL,
+	   "hildon-helper: \"ones\" should not match inside a word");
+  fail_if (hildon_helper_smart_match (haystack, "workers") != NULL,
+	   "hildon-helper: \"workers\" should not match \"work\"");
+  fail_if (hildon_helper_smart_match (long_haystack, "home") != long_haystack + 39,
+	   "hildon-helper: \"home\" should match in \"%s\"", long_haystack);
+  fail_if (hildon_helper_smart_match (long_haystack, "358") != long_haystack + 46,
+	   "hildon-helper: \"358\" should match in \"%s\"", long_haystack);
+  fail_if (hildon_helper_smart_match (haystack, "(wo") != haystack + 17,
+	   "hildon-helper: \"(wo\" should match anywhere in \"%s\"", haystack);
+  fail_if (hildon_helper_smart_match ("", "a") != NULL,
+	   "hildon-helper: nothing should match an empty haystack");
+}
+END_TEST
+
+/* ----- Test case for hildon_helper_utf8_strstrcasedecomp_needle_stripped -----*/
+
+/**
+ * Purpose: test searching accented text with a stripped needle
+ * Cases considered:
+ *    - Stripping removes case and accents, in and out of the BMP
+ *    - An unaccented needle matches an accented word start
+ *    - The needle does not match inside a word
+ */
+START_TEST (test_hildon_helper_strstrcasedecomp_regular)
+{
+  const gchar *haystack = "J\xc3\xbcrgen \xc3\x85ngstr\xc3\xb6m";
+  gunichar *nuni;
+
+  nuni = hildon_helper_strip_string ("\xc3\x85NG\xf0\x9d\x90\x80");
+  fail_if (nuni == NULL || nuni[0] != 'a' || nuni[1] != 'n' || nuni[2] != 'g' ||
+           nuni[3] != 0x1d400 || nuni[4] != 0,
+	   "hildon-helper: wrong stripped string");
+  g_free (nuni);
+
+  nuni = hildon_helper_strip_string ("ANGSTRO");
+  fail_if (hildon_helper_utf8_strstrcasedecomp_needle_stripped (haystack, nuni) != haystack + 8,
+	   "hildon-helper: \"angstro\" should match the second word of \"%s\"", haystack);
+  g_free (nuni);
+
+  nuni = hildon_helper_strip_string ("urgen");
+  fail_if (hildon_helper_utf8_strstrcasedecomp_needle_stripped (haystack, nuni) != NULL,
+	   "hildon-helper: \"urgen\" should not match inside a word");
+  g_free (nuni);
+}
+END_TEST
+
+/* ----- Test case for hildon_helper_normalize_string_to_buffer -----*/
+
+/**
+ * Purpose: test normalizing strings into a buffer of the caller
+ * Cases considered:
+ *    - Plain ASCII strings are copied as they are
+ *    - Accented strings give the result of hildon_helper_normalize_string()
+ *    - Too small and zero sized buffers truncate the result, and the
+ *      full length is returned in all cases
+ *    - Invalid UTF-8 strings give -1
+ */
+START_TEST (test_hildon_helper_normalize_string_to_buffer_regular)
+{
+  const gchar *ascii = "Mary Brown-Jones (work)";
+  const gchar *accented = "J\xc3\xbcrgen \xc3\x85ngstr\xc3\xb6m";
+  gchar buffer[64];
+  gchar *expected;
+  gsize expected_len;
+  gssize len;
+
+  /* Test 1: ASCII */
+  len = hildon_helper_normalize_string_to_buffer (ascii, buffer, sizeof (buffer));
+  fail_if (len != (gssize) strlen (ascii) || strcmp (buffer, ascii) != 0,
+           "hildon-helper: \"%s\" normalized to \"%s\" (%d)", ascii, buffer, (gint) len);
+
+  len = hildon_helper_normalize_string_to_buffer (ascii, buffer, 5);
+  fail_if (len != (gssize) strlen (ascii) || strcmp (buffer, "Mary") != 0,
+           "hildon-helper: \"%s\" truncated to \"%s\" (%d)", ascii, buffer, (gint) len);
+
+  len = hildon_helper_normalize_string_to_buffer (ascii, NULL, 0);
+  fail_if (len != (gssize) strlen (ascii),
+           "hildon-helper: length of \"%s\" is %d", ascii, (gint) len);
+
+  /* Test 2: transliterated */
+  expected = hildon_helper_normalize_string (accented);
+  fail_if (expected == NULL, "hildon-helper: cannot normalize \"%s\"", accented);
+  expected_len = strlen (expected);
+
+  len = hildon_helper_normalize_string_to_buffer (accented, buffer, sizeof (buffer));
+  fail_if (len != (gssize) expected_len || strcmp (buffer, expected) != 0,
+           "hildon-helper: \"%s\" normalized to \"%s\" (%d), expected \"%s\"",
+           accented, buffer, (gint) len, expected);
+
+  /* Test 3: too small and zero sized buffers */
+  len = hildon_helper_normalize_string_to_buffer (accented, buffer, 4);
+  fail_if (len != (gssize) expected_len || strlen (buffer) != 3 ||
+           strncmp (buffer, expected, 3) != 0,
+           "hildon-helper: \"%s\" truncated to \"%s\" (%d)", accented, buffer, (gint) len);
+
+  len = hildon_helper_normalize_string_to_buffer (accented, NULL, 0);
+  fail_if (len != (gssize) expected_len,
+           "hildon-helper: length of \"%s\" is %d, expected %u",
+           accented, (gint) len, (guint) expected_len);
+
+  g_free (expected);
+
+  /* Test 4: invalid UTF-8 */
+  len = hildon_helper_normalize_string_to_buffer ("invalid \xc3\x28", buffer, sizeof (buffer));
+  fail_if (len != -1, "hildon-helper: invalid UTF-8 normalized to \"%s\"", buffer);
+}
+END_TEST
+
+/* ----- Test case for hildon_smart_matcher_match -----*/
+
+/* What a smart-match search means: every normalized space-separated
+   token of @text is found by hildon_helper_smart_match() in the
+   normalized @string. */
+static gboolean
+reference_match (const gchar *text, const gchar *string)
+{
+  gchar **tokens;
+  gchar *haystack;
+  gboolean ret = TRUE;
+  guint i;
+
+  tokens = g_strsplit (text, " ", -1);
+  haystack = string ? hildon_helper_normalize_string (string) : NULL;
+
+  for (i = 0; tokens[i] != NULL && ret; i++)
+    {
+      gchar *needle = hildon_helper_normalize_string (tokens[i]);
+
+      if (needle != NULL)
+        ret = hildon_helper_smart_match (haystack, needle) != NULL;
+      g_free (needle);
+    }
+
+  g_free (haystack);
+  g_strfreev (tokens);
+
+  return ret;
+}
+
+/* The words "w<first>" to "w<first + n - 1>", separated by spaces */
+static gchar *
+create_many_words (guint first, guint n)
+{
+  GString *string = g_string_new (NULL);
+  guint i;
+
+  for (i = first; i < first + n; i++)
+    g_string_append_printf (string, "%sw%u", i > first ? " " : "", i);
+
+  return g_string_free (string, FALSE);
+}
+
+static const gchar *smart_match_rows[] = {
+  "Mary Brown-Jones (work)",
+  "",
+  NULL,
+  "J\xc3\xbcrgen \xc3\x85ngstr\xc3\xb6m",
+  "Ren\xc3\xa9" "e O'Brien",
+  "Hamalainen-Korhonen, Virtanen Makinen (home) +358",
+  "(555) 123-4567",
+  "invalid \xc3\x28 utf-8"
+};
+
+static const gchar *smart_match_queries[] = {
+  "",
+  " ",
+  "mar",
+  "MAR jon",
+  "jones mary",
+  "mary  jones",
+  "(wo",
+  "-",
+  "+358 home",
+  "jur ang",
+  "\xc3\x85NG j\xc3\xbc",
+  "renee o",
+  "o brien",
+  "'b",
+  "555 (",
+  "ones",
+  "invalid",
+  "\xc3\x28"
+};
+
+/**
+ * Purpose: test that a compiled smart-match query matches the same
+ * strings as hildon_helper_smart_match()
+ * Cases considered:
+ *    - Empty tokens, and tokens starting with a separator
+ *    - NULL, empty and invalid UTF-8 strings and queries
+ *    - Accented strings and queries
+ *    - More than 64 tokens, long strings
+ */
+START_TEST (test_hildon_smart_matcher_regular)
+{
+  HildonSmartMatcher *matcher;
+  gchar *long_row, *long_query, *longer_query;
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (smart_match_queries); i++)
+    {
+      matcher = hildon_smart_matcher_new (smart_match_queries[i]);
+
+      for (j = 0; j < G_N_ELEMENTS (smart_match_rows); j++)
+        fail_if (hildon_smart_matcher_match (matcher, smart_match_rows[j]) !=
+                 reference_match (smart_match_queries[i], smart_match_rows[j]),
+                 "hildon-smart-match: \"%s\" on \"%s\" differs from "
+                 "hildon_helper_smart_match()",
+                 smart_match_queries[i], smart_match_rows[j]);
+
+      hildon_smart_matcher_free (matcher);
+    }
+
+  long_row = create_many_words (0, 80);
+  long_query = create_many_words (1, 70);
+  longer_query = g_strconcat (long_query, " w99", NULL);
+
+  matcher = hildon_smart_matcher_new (long_query);
+  fail_if (!hildon_smart_matcher_match (matcher, long_row) ||
+           !reference_match (long_query, long_row),
+           "hildon-smart-match: 70 tokens should match 80 words");
+  hildon_smart_matcher_free (matcher);
+
+  matcher = hildon_smart_matcher_new (longer_query);
+  fail_if (hildon_smart_matcher_match (matcher, long_row) ||
+           reference_match (longer_query, long_row),
+           "hildon-smart-match: the 71st token should not match");
+  hildon_smart_matcher_free (matcher);
+
+  g_free (long_row);
+  g_free (long_query);
+  g_free (longer_query);
+}
+END_TEST
+
+/* ----- Test case for hildon_normalized_strings_new -----*/
+
+/* Checks that string @i of @normalized is what
+   hildon_helper_normalize_string() gives for @string */
+static void
+check_normalized_string (HildonNormalizedStrings *normalized,
+                         guint i,
+                         const gchar *string)
+{
+  gchar *expected = string ? hildon_helper_normalize_string (string) : NULL;
+  const gchar *result = hildon_normalized_strings_get (normalized, i);
+
+  fail_if ((expected == NULL) != (result == NULL) ||
+           (expected != NULL && strcmp (expected, result) != 0),
+           "hildon-smart-match: string %u is \"%s\", expected \"%s\"",
+           i, result ? result : "(null)", expected ? expected : "(null)");
+
+  g_free (expected);
+}
+
+/**
+ * Purpose: test normalizing many strings at once
+ * Cases considered:
+ *    - Each result is the one of hildon_helper_normalize_string()
+ *    - Strings that don't fit in the initial block of memory
+ *    - Invalid UTF-8 strings and NULL rows give NULL
+ */
+START_TEST (test_hildon_normalized_strings_regular)
+{
+  HildonNormalizedStrings *normalized;
+  GtkListStore *store;
+  GPtrArray *strings;
+  gchar *long_string;
+  guint i;
+
+  /* Longer than the 16 bytes per string guessed for the first block */
+  long_string = g_strnfill (300, 'e');
+  for (i = 0; i < 300; i += 30)
+    memcpy (long_string + i, "\xc3\xa9", 2);
+
+  strings = g_ptr_array_new ();
+  for (i = 0; i < G_N_ELEMENTS (smart_match_rows); i++)
+    if (smart_match_rows[i] != NULL)
+      g_ptr_array_add (strings, (gpointer) smart_match_rows[i]);
+  g_ptr_array_add (strings, long_string);
+  for (i = 0; i < 100; i++)
+    g_ptr_array_add (strings, (gpointer) smart_match_rows[i % 2 ? 0 : 3]);
+  g_ptr_array_add (strings, long_string);
+  g_ptr_array_add (strings, NULL);
+
+  /* Test 1: from an array */
+  normalized = hildon_normalized_strings_new ((const gchar * const *) strings->pdata);
+  fail_if (hildon_normalized_strings_get_length (normalized) != strings->len - 1,
+           "hildon-smart-match: %u strings, expected %u",
+           hildon_normalized_strings_get_length (normalized), strings->len - 1);
+  for (i = 0; i < strings->len - 1; i++)
+    check_normalized_string (normalized, i, g_ptr_array_index (strings, i));
+  hildon_normalized_strings_free (normalized);
+
+  /* Test 2: from a model with NULL rows */
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < G_N_ELEMENTS (smart_match_rows); i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, smart_match_rows[i], -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, long_string, -1);
+
+  normalized = hildon_normalized_strings_new_from_model (GTK_TREE_MODEL (store), 0);
+  fail_if (hildon_normalized_strings_get_length (normalized) !=
+           G_N_ELEMENTS (smart_match_rows) + 1,
+           "hildon-smart-match: %u rows, expected %u",
+           hildon_normalized_strings_get_length (normalized),
+           (guint) G_N_ELEMENTS (smart_match_rows) + 1);
+  for (i = 0; i < G_N_ELEMENTS (smart_match_rows); i++)
+    check_normalized_string (normalized, i, smart_match_rows[i]);
+  check_normalized_string (normalized, i, long_string);
+  hildon_normalized_strings_free (normalized);
+
+  g_object_unref (store);
+  g_ptr_array_free (strings, TRUE);
+  g_free (long_string);
+}
+END_TEST
+
+/* ----- Test case for hildon_smart_match_index_lookup -----*/
+
+/* Checks that @index finds the rows of @model that
+   hildon_helper_smart_match() finds one by one */
+static void
+check_index_lookup (HildonSmartMatchIndex *index,
+                    GtkTreeModel *model)
+{
+  GtkTreeIter iter;
+  GArray *rows;
+  guint i, j, row;
+
+  fail_if (hildon_smart_match_index_get_n_rows (index) !=
+           (guint) gtk_tree_model_iter_n_children (model, NULL),
+           "hildon-smart-match: the index has %u rows, the model %d",
+           hildon_smart_match_index_get_n_rows (index),
+           gtk_tree_model_iter_n_children (model, NULL));
+
+  for (i = 0; i < G_N_ELEMENTS (smart_match_queries); i++)
+    {
+      rows = hildon_smart_match_index_lookup (index, smart_match_queries[i]);
+
+      j = 0;
+      row = 0;
+      if (gtk_tree_model_get_iter_first (model, &iter))
+        do
+          {
+            gchar *text;
+            gboolean expected;
+
+            gtk_tree_model_get (model, &iter, 0, &text, -1);
+            expected = reference_match (smart_match_queries[i], text);
+            g_free (text);
+
+            if (expected)
+              {
+                fail_if (j >= rows->len || g_array_index (rows, guint, j) != row,
+                         "hildon-smart-match: \"%s\" should find row %u",
+                         smart_match_queries[i], row);
+                j++;
+              }
+            row++;
+          }
+        while (gtk_tree_model_iter_next (model, &iter));
+
+      fail_if (j != rows->len,
+               "hildon-smart-match: \"%s\" finds %u rows, expected %u",
+               smart_match_queries[i], rows->len, j);
+
+      g_array_free (rows, TRUE);
+    }
+}
+
+/**
+ * Purpose: test that the rows found in a smart-match index are the
+ * ones hildon_helper_smart_match() finds in the model
+ * Cases considered:
+ *    - Queries with several, empty, separator and accented tokens
+ *    - NULL, empty and invalid UTF-8 rows
+ *    - Rows inserted and deleted after the index is built: the index
+ *      keeps answering for the rows it was built from, and a new
+ *      index finds the current rows
+ */
+START_TEST (test_hildon_smart_match_index_regular)
+{
+  HildonSmartMatchIndex *index, *new_index;
+  GtkListStore *store, *snapshot;
+  GtkTreeIter iter;
+  guint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  snapshot = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < G_N_ELEMENTS (smart_match_rows); i++)
+    {
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, smart_match_rows[i], -1);
+      gtk_list_store_insert_with_values (snapshot, NULL, -1, 0, smart_match_rows[i], -1);
+    }
+
+  /* Test 1: lookups on a new index */
+  index = hildon_smart_match_index_new (GTK_TREE_MODEL (store), 0);
+  check_index_lookup (index, GTK_TREE_MODEL (store));
+
+  /* Test 2: change the model */
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, "Mark Jonsson", -1);
+  gtk_list_store_insert_with_values (store, NULL, 4, 0, "\xc3\x85sa Brown", -1);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 2);
+  gtk_list_store_remove (store, &iter);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "(work) 555", -1);
+
+  check_index_lookup (index, GTK_TREE_MODEL (snapshot));
+
+  new_index = hildon_smart_match_index_new (GTK_TREE_MODEL (store), 0);
+  check_index_lookup (new_index, GTK_TREE_MODEL (store));
+
+  hildon_smart_match_index_free (new_index);
+  hildon_smart_match_index_free (index);
+  g_object_unref (snapshot);
+  g_object_unref (store);
+}
+END_TEST
 
 /* ---------- Suite creation ---------- */
 
@@ -171,6 +609,12 @@ Suite *create_hildon_helper_suite()
   /* Create test cases */
   TCase *tc1 = tcase_create("hildon_helper_set_logical_font");
   TCase *tc2 = tcase_create("hildon_helper_set_logical_color");
+  TCase *tc3 = tcase_create("hildon_helper_smart_match");
+  TCase *tc4 = tcase_create("hildon_helper_utf8_strstrcasedecomp_needle_stripped");
+  TCase *tc5 = tcase_create("hildon_helper_normalize_string_to_buffer");
+  TCase *tc6 = tcase_create("hildon_smart_matcher_match");
+  TCase *tc7 = tcase_create("hildon_normalized_strings_new");
+  TCase *tc8 = tcase_create("hildon_smart_match_index_lookup");
 
   /* Create test case for set_logical_font and add it to the suite */
   tcase_add_checked_fixture(tc1, fx_setup_default_helper, fx_teardown_default_helper);
@@ -184,6 +628,30 @@ Suite *create_hildon_helper_suite()
   tcase_add_test(tc2, test_hildon_helper_set_logical_color_invalid);
   suite_add_tcase (s, tc2);
 
+  /* Create test case for smart_match and add it to the suite */
+  tcase_add_test(tc3, test_hildon_helper_smart_match_regular);
+  suite_add_tcase (s, tc3);
+
+  /* Create test case for strstrcasedecomp and add it to the suite */
+  tcase_add_test(tc4, test_hildon_helper_strstrcasedecomp_regular);
+  suite_add_tcase (s, tc4);
+
+  /* Create test case for normalize_string_to_buffer and add it to the suite */
+  tcase_add_test(tc5, test_hildon_helper_normalize_string_to_buffer_regular);
+  suite_add_tcase (s, tc5);
+
+  /* Create test case for smart_matcher_match and add it to the suite */
+  tcase_add_test(tc6, test_hildon_smart_matcher_regular);
+  suite_add_tcase (s, tc6);
+
+  /* Create test case for normalized_strings_new and add it to the suite */
+  tcase_add_test(tc7, test_hildon_normalized_strings_regular);
+  suite_add_tcase (s, tc7);
+
+  /* Create test case for smart_match_index_lookup and add it to the suite */
+  tcase_add_test(tc8, test_hildon_smart_match_index_regular);
+  suite_add_tcase (s, tc8);
+
   /* Return created suite */
   return s;             
 }
@@ -404,8 +404,49 @@ START_TEST (test_new_cancel_with_progress_bar_invalid)
 }
 END_TEST
 
-  
-  
+/**
+ * Purpose: Check that progress set through the note is applied to its bar.
+ * Cases considered:
+ *    - Set several fractions in a row, only the last one is applied once the main loop runs.
+ *    - Set a fraction out of range, it is clamped to 1.0.
+ *
+ */
+START_TEST (test_set_progress_fraction)
+{
+  GtkProgressBar * progress_bar=NULL;
+  gdouble fraction;
+
+  progress_bar = GTK_PROGRESS_BAR(gtk_progress_bar_new());
+  note = HILDON_NOTE(hildon_note_new_cancel_with_progress_bar(n_window,TEST_STRING,progress_bar));
+
+  /* Test 1: several fractions before the main loop runs */
+  hildon_note_set_progress_fraction (note, 0.25);
+  hildon_note_set_progress_fraction (note, 0.5);
+  hildon_note_set_progress_fraction (note, 0.75);
+  fail_if (gtk_progress_bar_get_fraction (progress_bar) != 0.0,
+           "hildon-note: progress applied before the main loop ran");
+
+  while (gtk_progress_bar_get_fraction (progress_bar) == 0.0)
+    gtk_main_iteration ();
+
+  fraction = gtk_progress_bar_get_fraction (progress_bar);
+  fail_if (fraction != 0.75,
+           "hildon-note: progress set to 0.75, bar shows %f", fraction);
+
+  /* Test 2: a fraction out of range */
+  hildon_note_set_progress_fraction (note, 2.0);
+  while (gtk_progress_bar_get_fraction (progress_bar) == 0.75)
+    gtk_main_iteration ();
+
+  fraction = gtk_progress_bar_get_fraction (progress_bar);
+  fail_if (fraction != 1.0,
+           "hildon-note: progress set to 2.0, bar shows %f", fraction);
+
+  gtk_widget_destroy (GTK_WIDGET (note));
+  note=NULL;
+}
+END_TEST
+
 /* ---------- Suite creation ---------- */
 Suite *create_hildon_note_suite()
 {
@@ -433,6 +474,7 @@ Suite *create_hildon_note_suite()
   tcase_add_checked_fixture(tc4, fx_setup_default_note, fx_teardown_default_note);
   tcase_add_test(tc4, test_new_cancel_with_progress_bar_regular);
   tcase_add_test(tc4, test_new_cancel_with_progress_bar_invalid);
+  tcase_add_test(tc4, test_set_progress_fraction);
   suite_add_tcase (s, tc4);
 
   /* Return created suite */
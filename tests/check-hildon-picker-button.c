@@ -110,6 +110,179 @@ START_TEST (test_hildon_picker_button_value)
 }
 END_TEST
 
+/**
+   Purpose: test that a date button shows the same value before and
+   after its selector is built.
+
+   Checks for:
+
+   - Setting and getting a date works before the selector is built.
+   - The selector built afterwards selects that date and prints the
+     value the button already displays.
+*/
+START_TEST (test_hildon_picker_button_deferred_date)
+{
+    HildonButton *date_button;
+    HildonTouchSelector *date_selector;
+    gchar *value;
+    guint year, month, day;
+
+    date_button = HILDON_BUTTON (hildon_date_button_new (HILDON_SIZE_AUTO,
+                                                         HILDON_BUTTON_ARRANGEMENT_VERTICAL));
+    g_object_ref_sink (date_button);
+
+    /* Test 1: set and get the date */
+    hildon_date_button_set_date (HILDON_DATE_BUTTON (date_button), 2010, 1, 28);
+    hildon_date_button_get_date (HILDON_DATE_BUTTON (date_button), &year, &month, &day);
+    fail_if (year != 2010 || month != 1 || day != 28,
+             "hildon-picker-button: expected 2010-1-28, got %u-%u-%u",
+             year, month, day);
+
+    /* Test 2: build the selector */
+    date_selector = hildon_picker_button_get_selector (HILDON_PICKER_BUTTON (date_button));
+    hildon_date_selector_get_date (HILDON_DATE_SELECTOR (date_selector), &year, &month, &day);
+    fail_if (year != 2010 || month != 1 || day != 28,
+             "hildon-picker-button: selector got %u-%u-%u", year, month, day);
+
+    value = hildon_touch_selector_get_current_text (date_selector);
+    fail_if (strcmp (value, hildon_button_get_value (date_button)) != 0,
+             "hildon-picker-button: selector prints `%s', button displays `%s'",
+             value, hildon_button_get_value (date_button));
+    g_free (value);
+
+    g_object_unref (date_button);
+}
+END_TEST
+
+/**
+   Purpose: test that cancelling a picker dialog restores the
+   selection it was shown with.
+
+   Checks for:
+
+   - The rows selected when the dialog is shown are selected again
+     after the dialog is closed without pressing Done, even if the
+     user changed the selection meanwhile.
+*/
+START_TEST (test_hildon_picker_button_cancel_selection)
+{
+    GtkWidget *dialog;
+    HildonTouchSelector *multi;
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    GList *rows;
+    gint i;
+
+    multi = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+    for (i = 0; i < 6; i++)
+        hildon_touch_selector_append_text (multi, "Row");
+    hildon_touch_selector_set_column_selection_mode (multi,
+                                                     HILDON_TOUCH_SELECTOR_SELECTION_MODE_MULTIPLE);
+
+    model = hildon_touch_selector_get_model (multi, 0);
+    for (i = 0; i < 6; i++) {
+        gtk_tree_model_iter_nth_child (model, &iter, NULL, i);
+        if (i != 2 && i != 5)
+            hildon_touch_selector_select_iter (multi, 0, &iter, FALSE);
+    }
+
+    dialog = hildon_picker_dialog_new (window);
+    hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (dialog), multi);
+    gtk_widget_show (dialog);
+
+    hildon_touch_selector_unselect_all (multi, 0);
+    gtk_tree_model_iter_nth_child (model, &iter, NULL, 5);
+    hildon_touch_selector_select_iter (multi, 0, &iter, FALSE);
+
+    gtk_dialog_response (GTK_DIALOG (dialog), GTK_RESPONSE_DELETE_EVENT);
+
+    rows = hildon_touch_selector_get_selected_rows (multi, 0);
+    fail_if (g_list_length (rows) != 4,
+             "hildon-picker-button: %u rows selected after cancelling, expected 4",
+             g_list_length (rows));
+    fail_if (gtk_tree_path_get_indices (g_list_nth_data (rows, 2))[0] != 3,
+             "hildon-picker-button: wrong rows selected after cancelling");
+    g_list_foreach (rows, (GFunc) gtk_tree_path_free, NULL);
+    g_list_free (rows);
+
+    gtk_widget_destroy (dialog);
+}
+END_TEST
+
+static void
+count_responses (GtkDialog *dialog,
+                 gint       response,
+                 gpointer   user_data)
+{
+    (*(gint *) user_data)++;
+}
+
+/**
+   Purpose: test that the picker dialog shared by the buttons of a
+   window only reacts to the selector it is showing.
+
+   Checks for:
+
+   - After a second button borrows the dialog, changing the selector
+     of the first button doesn't close the dialog.
+   - Changing the selector shown by the dialog still closes it.
+*/
+START_TEST (test_hildon_picker_button_shared_dialog)
+{
+    GtkWidget *other_window, *box, *dialog;
+    GtkButton *first, *second;
+    HildonTouchSelector *first_selector, *second_selector;
+    gint responses = 0;
+
+    other_window = hildon_window_new ();
+    box = gtk_vbox_new (FALSE, 0);
+    gtk_container_add (GTK_CONTAINER (other_window), box);
+
+    first = GTK_BUTTON (hildon_picker_button_new (HILDON_SIZE_AUTO,
+                                                  HILDON_BUTTON_ARRANGEMENT_VERTICAL));
+    first_selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+    hildon_touch_selector_append_text (first_selector, "Row one");
+    hildon_touch_selector_append_text (first_selector, "Row two");
+    hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (first), first_selector);
+    gtk_box_pack_start (GTK_BOX (box), GTK_WIDGET (first), FALSE, FALSE, 0);
+
+    second = GTK_BUTTON (hildon_picker_button_new (HILDON_SIZE_AUTO,
+                                                   HILDON_BUTTON_ARRANGEMENT_VERTICAL));
+    second_selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+    hildon_touch_selector_append_text (second_selector, "Row one");
+    hildon_touch_selector_append_text (second_selector, "Row two");
+    hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (second), second_selector);
+    gtk_box_pack_start (GTK_BOX (box), GTK_WIDGET (second), FALSE, FALSE, 0);
+
+    show_all_test_window (other_window);
+
+    /* Test 1: both buttons borrow the same dialog */
+    gtk_button_clicked (first);
+    dialog = gtk_widget_get_toplevel (GTK_WIDGET (first_selector));
+    fail_if (!HILDON_IS_PICKER_DIALOG (dialog),
+             "hildon-picker-button: the first selector is not in a picker dialog");
+    gtk_widget_hide (dialog);
+
+    gtk_button_clicked (second);
+    fail_if (gtk_widget_get_toplevel (GTK_WIDGET (second_selector)) != dialog,
+             "hildon-picker-button: the buttons of a window don't share the dialog");
+
+    /* Test 2: the first selector doesn't close it anymore */
+    g_signal_connect (dialog, "response", G_CALLBACK (count_responses), &responses);
+    hildon_touch_selector_set_active (first_selector, 0, 1);
+    fail_if (responses != 0,
+             "hildon-picker-button: the selector of another button closed the dialog");
+
+    /* Test 3: the selector it shows does */
+    hildon_touch_selector_set_active (second_selector, 0, 1);
+    fail_if (responses != 1,
+             "hildon-picker-button: the shown selector emitted %d responses, expected 1",
+             responses);
+
+    gtk_widget_destroy (other_window);
+}
+END_TEST
+
 Suite *create_hildon_picker_button_suite (void)
 {
     Suite *s = suite_create ("HildonPickerButton");
@@ -117,6 +290,9 @@ Suite *create_hildon_picker_button_suite (void)
     TCase *tc1 = tcase_create ("hildon_picker_button");
     tcase_add_checked_fixture (tc1, fx_setup, fx_teardown);
     tcase_add_test (tc1, test_hildon_picker_button_value);
+    tcase_add_test (tc1, test_hildon_picker_button_deferred_date);
+    tcase_add_test (tc1, test_hildon_picker_button_cancel_selection);
+    tcase_add_test (tc1, test_hildon_picker_button_shared_dialog);
     suite_add_tcase (s, tc1);
 
     return s;
@@ -0,0 +1,364 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Measures how long a HildonPickerDialog takes to open for different
+ * selector shapes. Each scenario is split in the phases a click on a
+ * HildonPickerButton goes through:
+ *
+ *   construct  building the selector, the button and the dialog
+ *   size       the size request of the dialog
+ *   realize    realizing the dialog
+ *   draw       showing the dialog, up to its first draw
+ *   click      a click on a fresh button, up to the first draw of
+ *              the dialog it opens. Picker buttons share their dialog
+ *              with the rest of the window, so from the second round
+ *              on this dialog is already realized.
+ *
+ * The median of every phase over ROUNDS runs is printed in
+ * milliseconds, one tab separated line per scenario, after a header
+ * line. Rounds where the dialog was never drawn are left out of the
+ * median, and a phase that failed in every round prints "n/a". It
+ * needs a display, run it under a local X server:
+ *
+ *   xvfb-run ./picker-benchmark [ROUNDS] > picker-benchmark.tsv
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <hildon/hildon.h>
+
+#define DRAW_TIMEOUT 5000
+
+enum
+{
+    PHASE_CONSTRUCT,
+    PHASE_SIZE,
+    PHASE_REALIZE,
+    PHASE_DRAW,
+    PHASE_CLICK,
+    N_PHASES
+};
+
+static const gchar *phase_names[N_PHASES] = {
+    "construct", "size", "realize", "draw", "click"
+};
+
+typedef HildonTouchSelector * (*SelectorBuilder) (guint n_rows);
+
+typedef struct
+{
+    const gchar *name;
+    SelectorBuilder builder;
+    guint n_rows;
+} Scenario;
+
+static HildonTouchSelector *
+build_text (guint n_rows)
+{
+    GtkListStore *store;
+    HildonTouchSelector *selector;
+    gchar label[32];
+    guint i;
+
+    selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new_text ());
+    store = GTK_LIST_STORE (hildon_touch_selector_get_model (selector, 0));
+
+    for (i = 0; i < n_rows; i++) {
+        g_snprintf (label, sizeof (label), "Row %u", i);
+        gtk_list_store_insert_with_values (store, NULL, -1, 0, label, -1);
+    }
+    hildon_touch_selector_set_active (selector, 0, n_rows / 2);
+
+    return selector;
+}
+
+static HildonTouchSelector *
+build_columns (guint n_rows)
+{
+    HildonTouchSelector *selector;
+    GtkListStore *store;
+    gchar label[32];
+    guint column, i;
+
+    selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_new ());
+
+    for (column = 0; column < 3; column++) {
+        store = gtk_list_store_new (1, G_TYPE_STRING);
+        for (i = 0; i < n_rows; i++) {
+            g_snprintf (label, sizeof (label), "%u.%u", column, i);
+            gtk_list_store_insert_with_values (store, NULL, -1, 0, label, -1);
+        }
+        hildon_touch_selector_append_text_column (selector, GTK_TREE_MODEL (store), TRUE);
+        hildon_touch_selector_set_active (selector, column, n_rows / 2);
+        g_object_unref (store);
+    }
+
+    return selector;
+}
+
+static HildonTouchSelector *
+build_date (guint n_rows)
+{
+    return HILDON_TOUCH_SELECTOR (hildon_date_selector_new ());
+}
+
+static HildonTouchSelector *
+build_time (guint n_rows)
+{
+    return HILDON_TOUCH_SELECTOR (hildon_time_selector_new ());
+}
+
+static HildonTouchSelector *
+build_entry (guint n_rows)
+{
+    HildonTouchSelector *selector;
+    gchar label[32];
+    guint i;
+
+    selector = HILDON_TOUCH_SELECTOR (hildon_touch_selector_entry_new_text ());
+    for (i = 0; i < n_rows; i++) {
+        g_snprintf (label, sizeof (label), "Entry %u", i);
+        hildon_touch_selector_append_text (selector, label);
+    }
+    hildon_touch_selector_set_live_search (selector, TRUE);
+
+    return selector;
+}
+
+static const Scenario scenarios[] = {
+    { "text-10",          build_text,    10 },
+    { "text-1000",        build_text,    1000 },
+    { "text-100000",      build_text,    100000 },
+    { "columns-3x1000",   build_columns, 1000 },
+    { "date",             build_date,    0 },
+    { "time",             build_time,    0 },
+    { "entry-search-1000", build_entry,  1000 }
+};
+
+static gboolean
+on_draw (GtkWidget *widget,
+         cairo_t   *cr,
+         gboolean  *drawn)
+{
+    *drawn = TRUE;
+
+    return FALSE;
+}
+
+static guint draw_timeout = 0;
+
+static gboolean
+on_timeout (gboolean *drawn)
+{
+    g_printerr ("No draw after %d ms, is there a display?\n", DRAW_TIMEOUT);
+    *drawn = TRUE;
+    draw_timeout = 0;
+
+    return FALSE;
+}
+
+/* Waits for @window to be drawn once, returns FALSE if it never was */
+static gboolean
+wait_for_draw (GtkWidget *window,
+               gboolean  *drawn)
+{
+    gboolean timed_out;
+
+    draw_timeout = g_timeout_add (DRAW_TIMEOUT, (GSourceFunc) on_timeout, drawn);
+    while (!*drawn)
+        gtk_main_iteration ();
+
+    /* The source is already gone if it fired */
+    timed_out = (draw_timeout == 0);
+    if (!timed_out) {
+        g_source_remove (draw_timeout);
+        draw_timeout = 0;
+    }
+
+    g_signal_handlers_disconnect_by_func (window, on_draw, drawn);
+
+    return !timed_out;
+}
+
+static GtkWidget *
+find_picker_dialog (void)
+{
+    GList *toplevels, *l;
+    GtkWidget *dialog = NULL;
+
+    toplevels = gtk_window_list_toplevels ();
+    for (l = toplevels; l != NULL && dialog == NULL; l = l->next) {
+        if (HILDON_IS_PICKER_DIALOG (l->data) && gtk_widget_get_visible (l->data))
+            dialog = l->data;
+    }
+    g_list_free (toplevels);
+
+    return dialog;
+}
+
+static void
+flush_events (void)
+{
+    while (gtk_events_pending ())
+        gtk_main_iteration ();
+}
+
+static void
+run_phases (const Scenario *scenario,
+            GtkWidget      *window,
+            gdouble        *times)
+{
+    HildonTouchSelector *selector;
+    GtkRequisition requisition;
+    GtkWidget *button;
+    GtkWidget *dialog;
+    GTimer *timer;
+    gboolean drawn = FALSE;
+
+    timer = g_timer_new ();
+
+    /* What a click does the first time, one phase at a time */
+    selector = scenario->builder (scenario->n_rows);
+    button = hildon_picker_button_new (HILDON_SIZE_FINGER_HEIGHT,
+                                       HILDON_BUTTON_ARRANGEMENT_VERTICAL);
+    hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (button), selector);
+    dialog = hildon_picker_dialog_new (GTK_WINDOW (window));
+    hildon_picker_dialog_set_selector (HILDON_PICKER_DIALOG (dialog), selector);
+    times[PHASE_CONSTRUCT] = g_timer_elapsed (timer, NULL);
+
+    g_timer_start (timer);
+    gtk_widget_get_preferred_size (dialog, NULL, &requisition);
+    times[PHASE_SIZE] = g_timer_elapsed (timer, NULL);
+
+    g_timer_start (timer);
+    gtk_widget_realize (dialog);
+    times[PHASE_REALIZE] = g_timer_elapsed (timer, NULL);
+
+    g_signal_connect (dialog, "draw", G_CALLBACK (on_draw), &drawn);
+    g_timer_start (timer);
+    gtk_widget_show (dialog);
+    if (wait_for_draw (dialog, &drawn))
+        times[PHASE_DRAW] = g_timer_elapsed (timer, NULL);
+    else
+        times[PHASE_DRAW] = -1;
+
+    gtk_widget_destroy (dialog);
+    gtk_widget_destroy (button);
+    flush_events ();
+
+    /* The same, as the user sees it */
+    selector = scenario->builder (scenario->n_rows);
+    button = hildon_picker_button_new (HILDON_SIZE_FINGER_HEIGHT,
+                                       HILDON_BUTTON_ARRANGEMENT_VERTICAL);
+    hildon_picker_button_set_selector (HILDON_PICKER_BUTTON (button), selector);
+    gtk_container_add (GTK_CONTAINER (window), button);
+    gtk_widget_show (button);
+    flush_events ();
+
+    drawn = FALSE;
+    g_timer_start (timer);
+    gtk_button_clicked (GTK_BUTTON (button));
+    dialog = find_picker_dialog ();
+    times[PHASE_CLICK] = -1;
+    if (dialog != NULL) {
+        g_signal_connect (dialog, "draw", G_CALLBACK (on_draw), &drawn);
+        if (wait_for_draw (dialog, &drawn))
+            times[PHASE_CLICK] = g_timer_elapsed (timer, NULL);
+        gtk_dialog_response (GTK_DIALOG (dialog), GTK_RESPONSE_DELETE_EVENT);
+    }
+
+    gtk_widget_destroy (button);
+    flush_events ();
+
+    g_timer_destroy (timer);
+}
+
+static gint
+compare_times (gconstpointer a,
+               gconstpointer b)
+{
+    gdouble da = *(const gdouble *) a;
+    gdouble db = *(const gdouble *) b;
+
+    return da < db ? -1 : da > db;
+}
+
+int
+main (int argc, char **argv)
+{
+    guint rounds;
+    GtkWidget *window;
+    gdouble *times;
+    guint n, round, phase;
+
+    gtk_init (&argc, &argv);
+
+    rounds = argc > 1 ? atoi (argv[1]) : 5;
+    if (rounds == 0)
+        rounds = 1;
+
+    window = hildon_window_new ();
+    gtk_widget_show (window);
+    flush_events ();
+
+    times = g_new (gdouble, N_PHASES * rounds);
+
+    g_print ("scenario");
+    for (phase = 0; phase < N_PHASES; phase++)
+        g_print ("\t%s_ms", phase_names[phase]);
+    g_print ("\n");
+
+    for (n = 0; n < G_N_ELEMENTS (scenarios); n++) {
+        for (round = 0; round < rounds; round++) {
+            gdouble round_times[N_PHASES];
+
+            run_phases (&scenarios[n], window, round_times);
+            for (phase = 0; phase < N_PHASES; phase++)
+                times[phase * rounds + round] = round_times[phase];
+        }
+
+        g_print ("%s", scenarios[n].name);
+        for (phase = 0; phase < N_PHASES; phase++) {
+            gdouble *phase_times = times + phase * rounds;
+            guint failed = 0;
+
+            /* Failed rounds are stored as -1 and sorted first, they
+             * don't count in the median */
+            qsort (phase_times, rounds, sizeof (gdouble), compare_times);
+            while (failed < rounds && phase_times[failed] < 0)
+                failed++;
+
+            if (failed == rounds)
+                g_print ("\tn/a");
+            else
+                g_print ("\t%.3f",
+                         phase_times[failed + (rounds - failed) / 2] * 1000);
+        }
+        g_print ("\n");
+    }
+
+    g_free (times);
+    gtk_widget_destroy (window);
+
+    return 0;
+}
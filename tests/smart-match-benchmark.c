@@ -0,0 +1,167 @@
+/*
+ * This file is a part of hildon tests
+ *
+ * Copyright (C) 2010 Nokia Corporation, all rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/*
+ * Compares hildon_helper_smart_match() with the byte by byte
+ * implementation it replaced, on a corpus of generated contact names,
+ * the same way a HildonLiveSearch filters an address book while the
+ * user types.
+ *
+ * Usage: smart-match-benchmark [N_CONTACTS] [ROUNDS]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <hildon/hildon-helper.h>
+
+static const gchar *first_names[] = {
+    "Aino", "Antti", "Eero", "Elina", "Hanna", "Jukka", "Kaisa", "Mikko",
+    "Pekka", "Sanna", "Tuomas", "Veera", "Alberto", "Beatriz", "Carlos",
+    "Dolores", "Ignacio", "Lucia", "John", "Mary", "Robert", "Patricia",
+    "Michael", "Jennifer", "Zhang", "Wei", "Priya", "Rahul", "Olga", "Dmitri"
+};
+
+static const gchar *last_names[] = {
+    "Korhonen", "Virtanen", "Makinen", "Nieminen", "Hamalainen", "Laine",
+    "Garcia Lopez", "Fernandez", "Martinez-Ruiz", "O'Brien", "Smith",
+    "Johnson", "Williams", "Brown-Jones", "van der Berg", "de la Cruz",
+    "Li", "Wang", "Sharma", "Ivanov", "McAllister", "Nguyen"
+};
+
+static const gchar *suffixes[] = {
+    "", "", "", "", " (work)", " (home)", " - mobile", ", Jr.", " <fax>",
+    " +358 40 1234567"
+};
+
+static const gchar *needles[] = {
+    "a", "m", "s", "ko", "jo", "mar", "bro", "cru", "van", "wor",
+    "mobi", "3584", "zz", "korhonen", "o'b"
+};
+
+/* The implementation of hildon_helper_smart_match() before it
+ * was vectorized, kept here as the reference. */
+static const gchar *
+reference_smart_match (const gchar *haystack, const gchar *needle)
+{
+    gint i = 0;
+
+    if (strlen (haystack) == 0) return NULL;
+
+    while (haystack[i] != '\0') {
+        while (haystack[i] != '\0' && !g_ascii_isalnum (haystack[i]))
+            i++;
+        if (g_ascii_strncasecmp (haystack + i, needle, strlen (needle)) == 0)
+            return haystack + i;
+        while (g_ascii_isalnum (haystack[i]))
+            i++;
+    }
+
+    return NULL;
+}
+
+static gchar **
+create_corpus (guint n_contacts)
+{
+    GRand *rand = g_rand_new_with_seed (42);
+    gchar **corpus = g_new0 (gchar *, n_contacts + 1);
+    guint i;
+
+    for (i = 0; i < n_contacts; i++) {
+        const gchar *first = first_names[g_rand_int_range (rand, 0, G_N_ELEMENTS (first_names))];
+        const gchar *last = last_names[g_rand_int_range (rand, 0, G_N_ELEMENTS (last_names))];
+        const gchar *suffix = suffixes[g_rand_int_range (rand, 0, G_N_ELEMENTS (suffixes))];
+
+        corpus[i] = g_strdup_printf ("%s %s%s", first, last, suffix);
+    }
+
+    g_rand_free (rand);
+
+    return corpus;
+}
+
+static gdouble
+run (gchar       **corpus,
+     guint         rounds,
+     gboolean      reference,
+     guint        *n_matches)
+{
+    GTimer *timer = g_timer_new ();
+    gdouble elapsed;
+    guint round, n, i;
+
+    *n_matches = 0;
+
+    for (round = 0; round < rounds; round++) {
+        for (n = 0; n < G_N_ELEMENTS (needles); n++) {
+            for (i = 0; corpus[i] != NULL; i++) {
+                const gchar *match = reference ?
+                    reference_smart_match (corpus[i], needles[n]) :
+                    hildon_helper_smart_match (corpus[i], needles[n]);
+                if (match)
+                    (*n_matches)++;
+            }
+        }
+    }
+
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    return elapsed;
+}
+
+int
+main (int argc, char **argv)
+{
+    guint n_contacts = argc > 1 ? atoi (argv[1]) : 5000;
+    guint rounds = argc > 2 ? atoi (argv[2]) : 20;
+    gchar **corpus;
+    guint n, i, ref_matches, matches;
+    gdouble ref_time, time;
+
+    corpus = create_corpus (n_contacts);
+
+    /* Both implementations must return the very same match */
+    for (n = 0; n < G_N_ELEMENTS (needles); n++) {
+        for (i = 0; corpus[i] != NULL; i++) {
+            if (reference_smart_match (corpus[i], needles[n]) !=
+                hildon_helper_smart_match (corpus[i], needles[n])) {
+                g_printerr ("Mismatch searching \"%s\" in \"%s\"\n",
+                            needles[n], corpus[i]);
+                return 1;
+            }
+        }
+    }
+
+    ref_time = run (corpus, rounds, TRUE, &ref_matches);
+    time = run (corpus, rounds, FALSE, &matches);
+
+    g_print ("%u contacts, %u needles, %u rounds\n",
+             n_contacts, (guint) G_N_ELEMENTS (needles), rounds);
+    g_print ("reference:  %8.2f ms (%u matches)\n", ref_time * 1000, ref_matches);
+    g_print ("smart_match: %7.2f ms (%u matches)\n", time * 1000, matches);
+    g_print ("speedup:    %8.2fx\n", time > 0 ? ref_time / time : 0.0);
+
+    g_strfreev (corpus);
+
+    return 0;
+}
@@ -58,5 +58,7 @@ Suite *create_hildon_window_suite(void);
 Suite *create_hildon_program_suite(void);
 Suite *create_hildon_composite_widget_suite(void);
 Suite *create_hildon_picker_button_suite (void);
+Suite *create_hildon_date_selector_suite (void);
+Suite *create_hildon_banner_suite (void);
 
 #endif